@@ -14,6 +14,7 @@
 
 #include "tuya_common.h"
 #include "tuya_gpio.h"
+#include "tuya_timer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +23,9 @@ extern "C" {
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
+/* edge trace: big-endian 16-bit intervals between edges, oldest first, saturated at 0xFFFF */
+#define HALL_SW_TRACE_SIZE          256     /* must be a power of 2 */
+#define HALL_SW_TRACE_UNIT_US       64      /* unit of the trace intervals */
 
 /***********************************************************
 ***********************typedef define***********************
@@ -30,15 +34,45 @@ typedef BYTE_T HSW_RET;
 #define HSW_OK                  0x00
 #define HSW_ERR_MALLOC_FAILED   0x01
 #define HSW_ERR_CB_UNDEFINED    0x02
+#define HSW_ERR_INVALID_PARM    0x03
+#define HSW_ERR_BUSY            0x04
 
-typedef VOID_T (*HALL_SW_CALLBACK)();
+typedef VOID_T (*HALL_SW_CALLBACK)(UINT_T edge_tm);    /* edge_tm: clock time of the credited edge */
 typedef struct {                    /* user define */
     TY_GPIO_PORT_E port;            /* hall switch port */
     BOOL_T active_low;              /* hall switch's active level is low? */
     HALL_SW_CALLBACK hall_sw_cb;    /* hall switch trigger callback function */
-    UINT_T invalid_intv;            /* it's invalid when the interval between two triggers is less than this time */
+    UINT_T invalid_intv;            /* it's invalid when the interval between two triggers is less than this time (us), lower limit in adaptive mode */
+    UINT_T invalid_intv_max;        /* upper limit of the invalid interval in adaptive mode (us) */
+    UCHAR_T invalid_ratio;          /* invalid interval in 1/256 of the rotation period, 0 means fixed invalid interval */
 } HALL_SW_DEF_T;
 
+typedef struct {
+    UINT_T edge_cnt;                /* edges captured by the irq handler */
+    UINT_T overflow_cnt;            /* edges dropped because the edge queue was full */
+    UCHAR_T max_depth;              /* peak edge queue depth seen by the main loop */
+    UINT_T accepted_cnt;            /* edges accepted as rotations */
+    UINT_T rejected_cnt;            /* edges rejected as bounce, glitch or irregular motion */
+    UINT_T wake_edge_cnt;           /* edges credited from pad wakeup */
+    UINT_T wake_latency_last;       /* latency from the last wakeup to its first edge reaching the main loop (us) */
+    UINT_T wake_latency_max;        /* maximum latency from wakeup to the first edge reaching the main loop (us) */
+    UINT_T wake_hold_last;          /* classifier hold from that edge to the first count after the last wakeup (us) */
+    UINT_T wake_hold_max;           /* maximum classifier hold after wakeup (us) */
+} HALL_SW_STAT_T;
+
+typedef struct {                    /* edge queue stress test result */
+    UINT_T num;                     /* entries the timer irq tried to push */
+    UINT_T pushed;                  /* entries put into the edge queue */
+    UINT_T overflow;                /* entries refused because the edge queue was full */
+    UINT_T popped;                  /* entries taken out by the main loop */
+    UINT_T lost;                    /* sequence numbers never popped */
+    UINT_T disorder;                /* entries popped twice or out of order */
+    UCHAR_T max_depth;              /* peak edge queue depth seen by the main loop during the test */
+    BOOL_T pass;                    /* every push was popped once and in order, every loss was an overflow */
+} HALL_SW_QTEST_T;
+
+typedef VOID_T (*HALL_SW_QTEST_CALLBACK)(IN CONST HALL_SW_QTEST_T *res);
+
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
@@ -60,6 +94,95 @@ HSW_RET tuya_reg_hall_sw(IN HALL_SW_DEF_T *hsw_def);
  */
 HSW_RET tuya_hall_sw_reset(VOID_T);
 
+/**
+ * @brief set hall switch as pad wakeup source, called before sleep
+ * @param[in] none
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_set_wakeup(VOID_T);
+
+/**
+ * @brief hall switch wakeup handler, called as early as possible after pad wakeup
+ * @param[in] none
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_wakeup_handler(VOID_T);
+
+/**
+ * @brief hall switch edge process, must be called in main loop
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_hall_sw_loop(VOID_T);
+
+/**
+ * @brief get the number of edges in the trace ring
+ * @param[in] none
+ * @return number of edges
+ */
+USHORT_T tuya_hall_sw_trace_get_num(VOID_T);
+
+/**
+ * @brief read the edge trace
+ * @param[in] idx: index of the first edge to read, 0 is the oldest edge
+ * @param[out] buf: output buffer, 2 bytes per edge
+ * @param[in] max_num: maximum number of edges to read
+ * @return number of edges read
+ */
+USHORT_T tuya_hall_sw_trace_read(IN CONST USHORT_T idx, OUT UCHAR_T *buf, IN CONST USHORT_T max_num);
+
+/**
+ * @brief replay an edge trace through the edge processing, as fast as possible
+ * @param[in] port: hall switch port, its define gives the filter parameters
+ * @param[in] trace: trace data in the format of tuya_hall_sw_trace_read()
+ * @param[in] num: number of edges
+ * @param[in] restart: TRUE - reset the replay state first, FALSE - continue the previous replay
+ * @param[in] replay_cb: called for every edge credited as a rotation, instead of the live callback
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_trace_replay(IN CONST TY_GPIO_PORT_E port, IN CONST UCHAR_T *trace, IN CONST USHORT_T num,
+                                  IN CONST BOOL_T restart, IN CONST HALL_SW_CALLBACK replay_cb);
+
+/**
+ * @brief get the average rotation period of hall switch
+ * @param[in] port: hall switch port
+ * @return average rotation period (us), 0 means unknown
+ */
+UINT_T tuya_hall_sw_get_period(IN CONST TY_GPIO_PORT_E port);
+
+/**
+ * @brief get the average rotation period learned by the trace replay
+ * @param[in] none
+ * @return average rotation period (us), 0 means unknown
+ */
+UINT_T tuya_hall_sw_get_replay_period(VOID_T);
+
+/**
+ * @brief get hall switch statistics
+ * @param[out] stat: hall switch statistics
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_get_stat(OUT HALL_SW_STAT_T *stat);
+
+/**
+ * @brief get the statistics of the trace replay since its last restart
+ * @param[out] stat: replay statistics
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_get_replay_stat(OUT HALL_SW_STAT_T *stat);
+
+/**
+ * @brief start the edge queue stress test, a hardware timer irq pushes numbered entries while the main loop pops them
+ * @param[in] timer: free hardware timer used as the producer
+ * @param[in] intv_us: interval of the timer irq (us)
+ * @param[in] burst: entries pushed in one timer irq
+ * @param[in] num: total entries to push
+ * @param[in] done_cb: called in main loop when the queue is drained after the last push
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_queue_test_start(IN CONST TY_HW_TIMER_TYPE_E timer, IN CONST UINT_T intv_us, IN CONST UCHAR_T burst,
+                                      IN CONST UINT_T num, IN CONST HALL_SW_QTEST_CALLBACK done_cb);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -22,6 +22,9 @@ extern "C" {
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
+#define KEY_LONG_PRESS_NUM      4       /* hold thresholds of a key */
+#define KEY_LATENCY_SLOT_NUM    8       /* key and event type pairs with latency statistics */
+#define KEY_LATENCY_HIST_NUM    8       /* bucket n counts latency below (2 << n) ms, the last one the rest */
 
 /***********************************************************
 ***********************typedef define***********************
@@ -30,11 +33,16 @@ typedef BYTE_T KEY_RET;
 #define KEY_OK                  0x00
 #define KEY_ERR_MALLOC_FAILED   0x01
 #define KEY_ERR_CB_UNDEFINED    0x02
+#define KEY_ERR_INVALID_PARM    0x03
 
 typedef BYTE_T KEY_PRESS_TYPE_E;
 #define SHORT_PRESS             0x00
 #define LONG_PRESS_FOR_TIME1    0x01
 #define LONG_PRESS_FOR_TIME2    0x02
+#define LONG_PRESS_FOR_TIME3    0x03
+#define LONG_PRESS_FOR_TIME4    0x04
+#define DOUBLE_PRESS            0x05
+#define CHORD_PRESS             0x06
 
 typedef VOID_T (*KEY_CALLBACK)(KEY_PRESS_TYPE_E type);
 typedef struct {                /* user define */
@@ -43,8 +51,40 @@ typedef struct {                /* user define */
     UINT_T long_press_time1;    /* key long press time1 set (ms) */
     UINT_T long_press_time2;    /* key long press time2 set (ms) */
     KEY_CALLBACK key_cb;        /* key press callback function */
+    UINT_T long_press_time3;    /* key long press time3 set (ms), 0 - unused */
+    UINT_T long_press_time4;    /* key long press time4 set (ms), 0 - unused */
+    UINT_T double_press_time;   /* max gap between two short presses (ms), 0 - no double press */
 } KEY_DEF_T;
 
+typedef struct {                /* user define, both keys must be registered */
+    TY_GPIO_PORT_E port1;       /* first key port */
+    TY_GPIO_PORT_E port2;       /* second key port */
+    UINT_T hold_time;           /* both keys held together (ms), should be less than their long press times */
+    KEY_CALLBACK key_cb;        /* chord callback function, called with CHORD_PRESS */
+} KEY_CHORD_DEF_T;
+
+typedef struct {
+    UINT_T event_cnt;           /* events detected by the scan timer */
+    UINT_T overflow_cnt;        /* events dropped because the event queue was full */
+    UINT_T latency_last;        /* latency from the last detection to its callback (us) */
+    UINT_T latency_max;         /* maximum latency from detection to callback (us) */
+} KEY_STAT_T;
+
+typedef struct {
+    UINT_T cnt;                 /* samples */
+    UINT_T min;                 /* minimum latency (us) */
+    UINT_T max;                 /* maximum latency (us) */
+    UINT_T sum;                 /* sum of latency for the average (us) */
+    USHORT_T hist[KEY_LATENCY_HIST_NUM];    /* latency histogram, saturated */
+} KEY_LATENCY_T;
+
+typedef struct {                /* latency excludes the hold time asked by the gesture */
+    TY_GPIO_PORT_E port;        /* key port, first key port for chords */
+    KEY_PRESS_TYPE_E type;      /* event type */
+    KEY_LATENCY_T cb;           /* from the press edge to the callback */
+    KEY_LATENCY_T disp;         /* from the press edge to the display refresh */
+} KEY_LATENCY_STAT_T;
+
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
@@ -59,6 +99,13 @@ typedef struct {                /* user define */
  */
 KEY_RET tuya_reg_key(IN KEY_DEF_T* key_def);
 
+/**
+ * @brief key chord register, both keys must be registered before
+ * @param[in] chord_def: user key chord define
+ * @return KEY_RET
+ */
+KEY_RET tuya_reg_key_chord(IN KEY_CHORD_DEF_T *chord_def);
+
 /**
  * @brief key reset
  * @param[in] none
@@ -66,6 +113,63 @@ KEY_RET tuya_reg_key(IN KEY_DEF_T* key_def);
  */
 KEY_RET tuya_key_reset(VOID_T);
 
+/**
+ * @brief key process, must be called in main loop, key callbacks are called here
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_loop(VOID_T);
+
+/**
+ * @brief key wakeup handler, called after pad wakeup and before tuya_key_reset()
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_wakeup_handler(VOID_T);
+
+/**
+ * @brief get key statistics
+ * @param[out] stat: key statistics
+ * @return KEY_RET
+ */
+KEY_RET tuya_key_get_stat(OUT KEY_STAT_T *stat);
+
+/**
+ * @brief mark the display refreshed, closes the latency of the last dispatched key event
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_latency_mark_disp(VOID_T);
+
+/**
+ * @brief drop the display latency of the last dispatched key event, its action did not change the display
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_latency_cancel_disp(VOID_T);
+
+/**
+ * @brief get the number of key latency statistics slots in use
+ * @param[in] none
+ * @return number of slots
+ */
+UCHAR_T tuya_key_get_latency_num(VOID_T);
+
+/**
+ * @brief get key latency statistics of one key and event type
+ * @param[in] idx: slot index
+ * @param[out] stat: latency statistics
+ * @return KEY_RET
+ */
+KEY_RET tuya_key_get_latency(IN CONST UCHAR_T idx, OUT KEY_LATENCY_STAT_T *stat);
+
+/**
+ * @brief clear key latency statistics
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_clear_latency(VOID_T);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -31,6 +31,8 @@ typedef BYTE_T LED_RET;
 #define LED_ERR_INVALID_PARM    0x01
 #define LED_ERR_MALLOC_FAILED   0x02
 
+#define LED_LEVEL_MAX           0xFF    /* full brightness */
+
 typedef BYTE_T LED_FLASH_MODE_E;
 #define LFM_SPEC_TIME           0x00    /* flash specified time */
 #define LFM_SPEC_COUNT          0x01    /* flash specified count */
@@ -42,7 +44,29 @@ typedef BYTE_T LED_FLASH_TYPE_E;
 #define LFT_STA_OFF_END_ON      0x02    /* start at light off and end at light on */
 #define LFT_STA_OFF_END_OFF     0x03    /* start at light off and end at light off */
 
+/* LED pattern, a const table of steps run by the led driver */
+typedef BYTE_T LED_PAT_OP_E;
+#define LED_PAT_OP_LEVEL        0x00    /* hold level "arg" for "val" ms, see tuya_set_led_level */
+#define LED_PAT_OP_REPEAT       0x01    /* jump to step "arg", "val" times in total, 0 - forever */
+#define LED_PAT_OP_END          0x02    /* end with level "arg" and call the end callback */
+
+typedef struct {
+    LED_PAT_OP_E op;            /* step operation */
+    UCHAR_T arg;                /* level, or jump target step */
+    USHORT_T val;               /* duration (ms), or repeat count */
+} LED_PAT_STEP_T;
+
+#define LED_PAT_ON(ms)          {LED_PAT_OP_LEVEL, LED_LEVEL_MAX, (ms)}
+#define LED_PAT_OFF(ms)         {LED_PAT_OP_LEVEL, 0, (ms)}
+#define LED_PAT_LEVEL(lv, ms)   {LED_PAT_OP_LEVEL, (lv), (ms)}
+#define LED_PAT_REPEAT(to, n)   {LED_PAT_OP_REPEAT, (to), (n)}
+#define LED_PAT_END(lv)         {LED_PAT_OP_END, (lv), 0}
+#define LED_PAT_MASK(mask, ms)  {LED_PAT_OP_LEVEL, (mask), (ms)}   /* led group: lit members for "ms" */
+
+#define LED_GROUP_MEMBER_MAX    8
+
 typedef VOID_T *LED_HANDLE;
+typedef VOID_T *LED_GROUP_HANDLE;
 typedef VOID_T (*LED_CALLBACK)();
 
 /***********************************************************
@@ -76,6 +100,14 @@ LED_RET tuya_led_reset(VOID_T);
  */
 LED_RET tuya_set_led_light(IN CONST LED_HANDLE handle, IN CONST BOOL_T on_off);
 
+/**
+ * @brief set led brightness level
+ * @param[in] handle: led handle
+ * @param[in] level: 0 - light off, LED_LEVEL_MAX - full on, levels between need a pwm pin
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_level(IN CONST LED_HANDLE handle, IN CONST UCHAR_T level);
+
 /**
  * @brief set led flash in time type and different flash interval
  * @param[in] handle: led handle
@@ -89,6 +121,41 @@ LED_RET tuya_set_led_light(IN CONST LED_HANDLE handle, IN CONST BOOL_T on_off);
  */
 LED_RET tuya_set_led_flash(IN CONST LED_HANDLE handle, IN CONST LED_FLASH_MODE_E mode, IN CONST LED_FLASH_TYPE_E type, IN CONST USHORT_T on_time, IN CONST USHORT_T off_time, IN CONST UINT_T total, IN CONST LED_CALLBACK flash_end_cb);
 
+/**
+ * @brief set led pattern
+ * @param[in] handle: led handle
+ * @param[in] pat: pattern steps, must stay valid while running, normally a const table
+ * @param[in] pat_end_cb: pattern end callback function
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_pattern(IN CONST LED_HANDLE handle, IN CONST LED_PAT_STEP_T *pat, IN CONST LED_CALLBACK pat_end_cb);
+
+/**
+ * @brief tuya create led group, the members are then driven together with one port write per gpio group
+ * @param[in] leds: member led handles, bit n of a group mask is leds[n]
+ * @param[in] num: number of members, 1 ~ LED_GROUP_MEMBER_MAX
+ * @param[out] handle: led group handle
+ * @return LED_RET
+ */
+LED_RET tuya_create_led_group(IN CONST LED_HANDLE *leds, IN CONST UCHAR_T num, OUT LED_GROUP_HANDLE *handle);
+
+/**
+ * @brief set the lit members of a led group
+ * @param[in] handle: led group handle
+ * @param[in] mask: lit members, bit n is member n
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_group_light(IN CONST LED_GROUP_HANDLE handle, IN CONST UCHAR_T mask);
+
+/**
+ * @brief set led group pattern, all members follow one phase
+ * @param[in] handle: led group handle
+ * @param[in] pat: pattern steps, the level of a step is the mask of lit members, see LED_PAT_MASK
+ * @param[in] pat_end_cb: pattern end callback function
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_group_pattern(IN CONST LED_GROUP_HANDLE handle, IN CONST LED_PAT_STEP_T *pat, IN CONST LED_CALLBACK pat_end_cb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -98,6 +98,20 @@ SEG_LCD_RET tuya_seg_lcd_init(SEG_LCD_PIN_T pin_def);
  */
 SEG_LCD_RET tuya_seg_lcd_reset(VOID_T);
 
+/**
+ * @brief segment lcd sleep, stops the scan and the flash timer and parks the pins
+ * @param[in] none
+ * @return SEG_LCD_RET
+ */
+SEG_LCD_RET tuya_seg_lcd_sleep(VOID_T);
+
+/**
+ * @brief segment lcd wakeup, the scan restarts from the first COM phase within one scan step
+ * @param[in] none
+ * @return SEG_LCD_RET
+ */
+SEG_LCD_RET tuya_seg_lcd_wakeup(VOID_T);
+
 /**
  * @brief display number
  * @param[in] num: number displayed in decimal
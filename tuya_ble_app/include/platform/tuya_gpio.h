@@ -27,6 +27,11 @@ typedef BYTE_T GPIO_RET;
 #define GPIO_ERR_MALLOC_FAILED  0x02
 #define GPIO_ERR_CB_UNDEFINED   0x03
 
+#define TY_GPIO_PIN_PER_GROUP   8
+#define TY_GPIO_GROUP_NUM       (TY_GPIO_MAX / TY_GPIO_PIN_PER_GROUP)
+#define TY_GPIO_GROUP(port)     ((port) / TY_GPIO_PIN_PER_GROUP)
+#define TY_GPIO_BIT(port)       (1 << ((port) % TY_GPIO_PIN_PER_GROUP))
+
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
@@ -78,6 +83,12 @@ typedef BYTE_T TY_GPIO_IRQ_TYPE_E;
 
 typedef VOID_T (*TY_GPIO_IRQ_CB)(TY_GPIO_PORT_E port);
 
+typedef struct {
+    UINT_T cnt;                     /* dispatched irqs */
+    UINT_T sum;                     /* total dispatch time, callbacks included (clock tick) */
+    UINT_T max;                     /* longest dispatch time (clock tick) */
+} TY_GPIO_IRQ_STAT_T;
+
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
@@ -126,6 +137,24 @@ GPIO_RET tuya_gpio_set_mode(IN CONST TY_GPIO_PORT_E port, IN CONST TY_GPIO_MODE_
  */
 GPIO_RET tuya_gpio_write(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T level);
 
+/**
+ * @brief tuya gpio write several pins of a group at once
+ * @param[in] group: gpio group, 0 - A, 1 - B, 2 - C, 3 - D
+ * @param[in] mask: pins to write, bit n is pin n of the group
+ * @param[in] level: output levels, bit n is the level of pin n of the group
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_write_port(IN CONST UCHAR_T group, IN CONST UCHAR_T mask, IN CONST UCHAR_T level);
+
+/**
+ * @brief tuya gpio enable or disable the output of several pins of a group at once
+ * @param[in] group: gpio group, 0 - A, 1 - B, 2 - C, 3 - D
+ * @param[in] mask: pins to set, bit n is pin n of the group
+ * @param[in] out_en: output enable, bit n set - pin n is output, bit n clear - pin n is high impedance
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_set_port_output(IN CONST UCHAR_T group, IN CONST UCHAR_T mask, IN CONST UCHAR_T out_en);
+
 /**
  * @brief tuya gpio read
  * @param[in] port: gpio number
@@ -133,6 +162,13 @@ GPIO_RET tuya_gpio_write(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T level);
  */
 BOOL_T tuya_gpio_read(IN CONST TY_GPIO_PORT_E port);
 
+/**
+ * @brief tuya gpio read all pins of a group at once
+ * @param[in] group: gpio group, 0 - A, 1 - B, 2 - C, 3 - D
+ * @return input levels, bit n is the level of pin n of the group
+ */
+UCHAR_T tuya_gpio_read_port(IN CONST UCHAR_T group);
+
 /**
  * @brief tuya gpio interrupt init
  * @param[in] port: gpio number
@@ -142,6 +178,15 @@ BOOL_T tuya_gpio_read(IN CONST TY_GPIO_PORT_E port);
  */
 GPIO_RET tuya_gpio_irq_init(IN CONST TY_GPIO_PORT_E port, IN CONST TY_GPIO_IRQ_TYPE_E trig_type, IN TY_GPIO_IRQ_CB irq_cb);
 
+/**
+ * @brief tuya gpio set as pad wakeup source
+ * @param[in] port: gpio number
+ * @param[in] level: wakeup level
+ * @param[in] en: TRUE - enable, FALSE - disable
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_set_wakeup(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T level, IN CONST BOOL_T en);
+
 /*
  * @brief tuya gpio irq handler
  * @param[in] none
@@ -149,6 +194,13 @@ GPIO_RET tuya_gpio_irq_init(IN CONST TY_GPIO_PORT_E port, IN CONST TY_GPIO_IRQ_T
  */
 VOID_T tuya_gpio_irq_handler(VOID_T);
 
+/**
+ * @brief get the cost of the gpio irq dispatch
+ * @param[out] stat: dispatch statistics
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_get_irq_stat(OUT TY_GPIO_IRQ_STAT_T *stat);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,63 @@
+/**
+ * @file tuya_pwm.h
+ * @author lifan
+ * @brief tuya pwm header file
+ * @version 1.0
+ * @date 2021-09-23
+ *
+ * @copyright Copyright (c) tuya.inc 2021
+ *
+ */
+
+#ifndef __TUYA_PWM_H__
+#define __TUYA_PWM_H__
+
+#include "tuya_common.h"
+#include "tuya_gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+************************micro define************************
+***********************************************************/
+typedef BYTE_T PWM_RET;
+#define PWM_OK                  0x00
+#define PWM_ERR_INVALID_PARM    0x01    /* the port has no pwm output */
+
+#define TY_PWM_DUTY_MAX         0xFF
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+/**
+ * @brief tuya pwm init, the output starts off
+ * @param[in] port: gpio number
+ * @param[in] freq: pwm frequency (Hz)
+ * @param[in] active_low: TRUE - active low, FALSE - active high
+ * @return PWM_RET
+ */
+PWM_RET tuya_pwm_init(IN CONST TY_GPIO_PORT_E port, IN CONST UINT_T freq, IN CONST BOOL_T active_low);
+
+/**
+ * @brief tuya pwm set duty, 0 and TY_PWM_DUTY_MAX drive the pin as gpio with pwm stopped
+ * @param[in] port: gpio number
+ * @param[in] duty: active duty, 0 ~ TY_PWM_DUTY_MAX
+ * @return PWM_RET
+ */
+PWM_RET tuya_pwm_set_duty(IN CONST TY_GPIO_PORT_E port, IN CONST UCHAR_T duty);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TUYA_PWM_H__ */
@@ -21,6 +21,7 @@ extern "C" {
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
+#define TY_CLOCK_TICK_PER_US    16      /* clock time ticks per microsecond */
 
 /***********************************************************
 ***********************typedef define***********************
@@ -61,6 +61,13 @@ VOID_T hula_hoop_reset_timer_for_key_event(VOID_T);
  */
 VOID_T hula_hoop_reset_timer_for_hall_event(VOID_T);
 
+/**
+ * @brief get stop rotating confirm time from the rotation period
+ * @param[in] period: average rotation period (us), 0 means unknown
+ * @return confirm time (ms)
+ */
+UINT_T hula_hoop_get_stop_rotating_confirm_time(IN CONST UINT_T period);
+
 /**
  * @brief reset upd_time_data_timer
  * @param[in] none
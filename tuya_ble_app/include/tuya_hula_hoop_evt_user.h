@@ -47,6 +47,56 @@ VOID_T hula_hoop_key_hall_init(VOID_T);
  */
 VOID_T hula_hoop_key_hall_init_deepRetn(VOID_T);
 
+/**
+ * @brief key latency process after the display is refreshed, called when the segment lcd is rendered
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_key_disp_refreshed(VOID_T);
+
+/**
+ * @brief set hall sensor as wakeup source, called before sleep
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_hall_set_wakeup(VOID_T);
+
+/**
+ * @brief hall sensor wakeup handler, called first after pad wakeup
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_hall_wakeup_handler(VOID_T);
+
+/**
+ * @brief key wakeup handler, called after pad wakeup
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_key_wakeup_handler(VOID_T);
+
+/**
+ * @brief get the average rotation period measured by hall sensor
+ * @param[in] none
+ * @return average rotation period (us), 0 means unknown
+ */
+UINT_T hula_hoop_get_rotation_period(VOID_T);
+
+/**
+ * @brief key and hall sensor process, called in main loop
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_key_hall_loop(VOID_T);
+
+/**
+ * @brief UART debug command handler, called by "tuya_uart_debug_handler()"
+ * @param[in] frame: debug frame
+ * @param[in] len: frame length
+ * @return none
+ */
+VOID_T hula_hoop_uart_debug_handler(IN UCHAR_T *frame, IN CONST USHORT_T len);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -22,6 +22,9 @@ extern "C" {
 ************************micro define************************
 ***********************************************************/
 #define SPORT_DATA_HISTORY_SIZE 30
+#define USER_WEIGHT_DEFAULT     60      /* kg */
+#define USER_WEIGHT_MIN         20      /* kg */
+#define USER_WEIGHT_MAX         200     /* kg */
 
 /***********************************************************
 ***********************typedef define***********************
@@ -29,6 +32,7 @@ extern "C" {
 typedef struct {
     USHORT_T time_realtime;
     USHORT_T count_realtime;
+    USHORT_T cadence_realtime;
     USHORT_T calories_realtime;
     USHORT_T time_total_today;
     UINT_T count_total_today;
@@ -75,6 +79,13 @@ BOOL_T hula_hoop_update_sport_data_time(VOID_T);
  */
 VOID_T hula_hoop_update_sport_data_count(VOID_T);
 
+/**
+ * @brief update sport data --cadence
+ * @param[in] period: average rotation period (us), 0 means not rotating
+ * @return none
+ */
+VOID_T hula_hoop_update_sport_data_cadence(IN CONST UINT_T period);
+
 /**
  * @brief update sport data --calories
  * @param[in] none
@@ -82,6 +93,20 @@ VOID_T hula_hoop_update_sport_data_count(VOID_T);
  */
 VOID_T hula_hoop_update_sport_data_calories(VOID_T);
 
+/**
+ * @brief set user weight, rebuilds the calorie table
+ * @param[in] weight: user weight (kg)
+ * @return none
+ */
+VOID_T hula_hoop_set_user_weight(IN CONST UINT_T weight);
+
+/**
+ * @brief get user weight
+ * @param[in] none
+ * @return user weight (kg)
+ */
+UCHAR_T hula_hoop_get_user_weight(VOID_T);
+
 /**
  * @brief set target time for today
  * @param[in] tar_tm: target_time
@@ -35,7 +35,8 @@ typedef BYTE_T DISP_DATA_E;
 #define DISP_DATA_TIME      0x00
 #define DISP_DATA_COUNT     0x01
 #define DISP_DATA_CALORIES  0x02
-#define DISP_DATA_NONE      0x03
+#define DISP_DATA_CADENCE   0x03
+#define DISP_DATA_NONE      0x04
 
 typedef BYTE_T LED_FUNC_E;
 #define LED_FUNC_DATA       0x00
@@ -144,6 +145,13 @@ BOOL_T hula_hoop_disp_is_flash(VOID_T);
  */
 DISP_MODE_E hula_hoop_get_disp_mode(VOID_T);
 
+/**
+ * @brief get the render key of the current interface, it changes whenever the lcd content would change
+ * @param[in] none
+ * @return render key
+ */
+UINT_T hula_hoop_get_disp_render_key(VOID_T);
+
 /**
  * @brief switch displayed data
  * @param[in] none
@@ -0,0 +1,97 @@
+/**
+ * @file tuya_hula_hoop_svc_session.h
+ * @author lifan
+ * @brief hula hoop workout session service processing module header file
+ * @version 1.0
+ * @date 2021-09-23
+ *
+ * @copyright Copyright (c) tuya.inc 2021
+ *
+ */
+
+#ifndef __TUYA_HULA_HOOP_SVC_SESSION_H__
+#define __TUYA_HULA_HOOP_SVC_SESSION_H__
+
+#include "tuya_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************
+************************micro define************************
+***********************************************************/
+#define SESSION_SET_TABLE_SIZE  16
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    UINT_T start_time;      /* local time of the first rotation, seconds of the day */
+    USHORT_T duration;      /* from the first to the last rotation (s) */
+    USHORT_T count;         /* rotations of the set */
+    USHORT_T cadence;       /* mean cadence of the set (rpm) */
+    USHORT_T rest;          /* rest interval before the set (s), 0 for the first set */
+} SESSION_SET_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+/**
+ * @brief workout session process module init
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_session_init(VOID_T);
+
+/**
+ * @brief update the session clock, called by the 100ms timer
+ * @param[in] time_inc: time increment (ms)
+ * @return none
+ */
+VOID_T hula_hoop_session_update_time(IN CONST UINT_T time_inc);
+
+/**
+ * @brief session process on one valid rotation
+ * @param[in] age_ms: time from the rotation edge to now (ms)
+ * @return none
+ */
+VOID_T hula_hoop_session_on_rotation(IN CONST UINT_T age_ms);
+
+/**
+ * @brief session process when the rotation stops, closes the current set
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_session_on_stop(VOID_T);
+
+/**
+ * @brief session process when the device is no longer used, ends the session
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_session_on_end(VOID_T);
+
+/**
+ * @brief get the number of sets in the set table
+ * @param[in] none
+ * @return number of sets
+ */
+UCHAR_T hula_hoop_get_session_set_num(VOID_T);
+
+/**
+ * @brief get one set from the set table
+ * @param[in] idx: set index, 0 is the oldest set
+ * @return set address, NULL if the index is out of range
+ */
+CONST SESSION_SET_T *hula_hoop_get_session_set(IN CONST UCHAR_T idx);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TUYA_HULA_HOOP_SVC_SESSION_H__ */
@@ -16,6 +16,18 @@
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
+#define HALL_SW_EDGE_QUEUE_SIZE     16      /* must be a power of 2 */
+#define HALL_SW_EDGE_QUEUE_MASK     (HALL_SW_EDGE_QUEUE_SIZE - 1)
+#define HALL_SW_PERIOD_MAX_MS       3000    /* longer intervals are treated as a restart of rotation */
+#define HALL_SW_PERIOD_FRAC_BITS    4       /* fractional bits of the averaged period */
+#define HALL_SW_PERIOD_AVG_SHIFT    3       /* averaging weight of a new period: 1/8 */
+#define HALL_SW_CLS_WIN_SIZE        5       /* intervals in the classifier window, odd for a true median */
+#define HALL_SW_CLS_GLITCH_SHIFT    1       /* intervals shorter than 1/2 median are glitches */
+#define HALL_SW_CLS_SPREAD_SHIFT    2       /* window is steady when its inter-quartile spread is within 1/4 median */
+#define HALL_SW_WAKE_HOLD_MAX_MS    ((HALL_SW_CLS_WIN_SIZE + 1) * HALL_SW_PERIOD_MAX_MS)    /* longest hold of a steady start */
+#define HALL_SW_TRACE_MASK          (HALL_SW_TRACE_SIZE - 1)
+#define HALL_SW_TRACE_UNIT_SHIFT    10      /* HALL_SW_TRACE_UNIT_US in clock ticks: 64us * 16 = 1 << 10 */
+#define HALL_SW_TRACE_INTV_MAX      0xFFFF
 
 /***********************************************************
 ***********************typedef define***********************
@@ -23,13 +35,66 @@
 typedef struct hall_sw_manage_s {
     struct hall_sw_manage_s *next;
     HALL_SW_DEF_T *def;
+    volatile HALL_SW_STAT_T *stat;  /* statistics the edges are counted into */
     UINT_T wk_tm;
+    UINT_T period_avg;              /* moving average of the rotation period (tick, Q4), 0 means unknown */
+    UINT_T invalid_tick;            /* current invalid interval (tick) */
+    BOOL_T wake_level;              /* armed pad wakeup level */
+    UINT_T cls_win[HALL_SW_CLS_WIN_SIZE];   /* recent intervals for classification (tick) */
+    UCHAR_T cls_cnt;                /* valid intervals in the classifier window */
+    UCHAR_T cls_idx;                /* next write position of the classifier window */
+    UCHAR_T cls_pending;            /* edges waiting for a steady window */
 } HALL_SW_MANAGE_T;
 
+typedef struct {
+    HALL_SW_MANAGE_T *hsw_mag;      /* triggered hall switch */
+    UINT_T tm;                      /* clock time of the edge */
+} HALL_SW_EDGE_T;
+
+typedef struct {
+    HALL_SW_EDGE_T buf[HALL_SW_EDGE_QUEUE_SIZE];
+    UCHAR_T head;                   /* written by the irq handler only */
+    UCHAR_T tail;                   /* written by the main loop only */
+} HALL_SW_EDGE_QUEUE_T;
+
+typedef struct {
+    USHORT_T intv[HALL_SW_TRACE_SIZE];      /* interval from the previous edge (HALL_SW_TRACE_UNIT_US) */
+    USHORT_T head;                  /* next write position */
+    USHORT_T num;                   /* valid edges, oldest are overwritten when full */
+    UINT_T last_tm;                 /* clock time of the last recorded edge */
+} HALL_SW_TRACE_T;
+
+typedef struct {
+    HALL_SW_QTEST_T res;
+    HALL_SW_QTEST_CALLBACK done_cb;
+    TY_HW_TIMER_TYPE_E timer;
+    UCHAR_T burst;
+    UINT_T seq;                     /* next sequence number to push, written by the timer irq only */
+    UINT_T expect;                  /* next sequence number expected, written by the main loop only */
+    BOOL_T producing;               /* cleared by the timer irq after the last push */
+    BOOL_T running;
+} HALL_SW_QTEST_STATE_T;
+
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
 STATIC HALL_SW_MANAGE_T *sg_hsw_mag_list = NULL;
+STATIC HALL_SW_MANAGE_T *sg_hsw_port_tbl[TY_GPIO_MAX];    /* hall switch indexed by port, for the irq handler */
+STATIC volatile HALL_SW_EDGE_QUEUE_T sg_hsw_edge_queue;
+STATIC volatile HALL_SW_STAT_T sg_hsw_stat;
+STATIC UINT_T sg_hsw_wake_tm = 0;
+STATIC BOOL_T sg_hsw_wake_pending = FALSE;        /* first edge after wakeup not yet in the main loop */
+STATIC UINT_T sg_hsw_wake_deq_tm = 0;               /* clock time that edge reached the main loop */
+STATIC BOOL_T sg_hsw_wake_hold = FALSE;             /* that edge is held by the classifier, not yet counted */
+STATIC HALL_SW_TRACE_T sg_hsw_trace;
+STATIC UINT_T sg_hsw_replay_tm = 0;
+/* replay runs on a private copy, the live edge processing and its callback are never touched */
+STATIC HALL_SW_DEF_T sg_hsw_replay_def;
+STATIC HALL_SW_MANAGE_T sg_hsw_replay_mag;
+STATIC volatile HALL_SW_STAT_T sg_hsw_replay_stat;
+/* queue test entries carry this marker instead of a hall switch and a sequence number instead of a clock time */
+STATIC HALL_SW_MANAGE_T sg_hsw_qtest_mag;
+STATIC volatile HALL_SW_QTEST_STATE_T sg_hsw_qtest;
 
 /***********************************************************
 ***********************function define**********************
@@ -38,20 +103,69 @@ STATIC VOID_T __hall_sw_irq_handler(TY_GPIO_PORT_E port);
 
 /**
  * @brief hall switch gpio init
- * @param[in] pin: pin number
- * @param[in] active_low: TRUE - active low, FALSE - active high
+ * @param[in] hsw_mag: hall switch management
  * @return none
  */
-STATIC VOID_T __hall_sw_gpio_init(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T active_low)
+STATIC VOID_T __hall_sw_gpio_init(IN CONST HALL_SW_MANAGE_T *hsw_mag)
 {
-    tuya_gpio_init(port, TRUE, active_low);
-    if (active_low) {
+    TY_GPIO_PORT_E port = hsw_mag->def->port;
+
+    tuya_gpio_init(port, TRUE, hsw_mag->def->active_low);
+    if (hsw_mag->def->active_low) {
         tuya_gpio_irq_init(port, TY_GPIO_IRQ_FALLING, __hall_sw_irq_handler);
     } else {
         tuya_gpio_irq_init(port, TY_GPIO_IRQ_RISING, __hall_sw_irq_handler);
     }
 }
 
+/**
+ * @brief update the invalid interval according to the rotation period
+ * @param[inout] hsw_mag: hall switch management
+ * @return none
+ */
+STATIC VOID_T __hall_sw_update_invalid_intv(INOUT HALL_SW_MANAGE_T *hsw_mag)
+{
+    UINT_T intv_min, intv_max, intv;
+
+    intv_min = hsw_mag->def->invalid_intv * TY_CLOCK_TICK_PER_US;
+    if ((hsw_mag->def->invalid_ratio == 0) || (hsw_mag->period_avg == 0)) {
+        hsw_mag->invalid_tick = intv_min;
+        return;
+    }
+    intv_max = hsw_mag->def->invalid_intv_max * TY_CLOCK_TICK_PER_US;
+    intv = (hsw_mag->period_avg >> (HALL_SW_PERIOD_FRAC_BITS + 8)) * hsw_mag->def->invalid_ratio;
+    if (intv < intv_min) {
+        intv = intv_min;
+    } else if (intv > intv_max) {
+        intv = intv_max;
+    } else {
+        ;
+    }
+    hsw_mag->invalid_tick = intv;
+}
+
+/**
+ * @brief update the moving average of the rotation period
+ * @param[inout] hsw_mag: hall switch management
+ * @param[in] intv: interval between the last two valid triggers (tick)
+ * @return none
+ */
+STATIC VOID_T __hall_sw_update_period(INOUT HALL_SW_MANAGE_T *hsw_mag, IN CONST UINT_T intv)
+{
+    UINT_T period;
+
+    if (intv > (HALL_SW_PERIOD_MAX_MS * 1000 * TY_CLOCK_TICK_PER_US)) {
+        hsw_mag->period_avg = 0;
+        return;
+    }
+    period = intv << HALL_SW_PERIOD_FRAC_BITS;
+    if (hsw_mag->period_avg == 0) {
+        hsw_mag->period_avg = period;
+    } else {
+        hsw_mag->period_avg += ((INT_T)(period - hsw_mag->period_avg)) >> HALL_SW_PERIOD_AVG_SHIFT;
+    }
+}
+
 /**
  * @brief hall switch register
  * @param[in] hsw_def: user hall switch define
@@ -63,22 +177,29 @@ HSW_RET tuya_reg_hall_sw(IN HALL_SW_DEF_T *hsw_def)
     if (hsw_def->hall_sw_cb == NULL) {
         return HSW_ERR_CB_UNDEFINED;
     }
+    if (hsw_def->port >= TY_GPIO_MAX) {
+        return HSW_ERR_INVALID_PARM;
+    }
 
     /* allocate and clear for hall_sw_mag */
     HALL_SW_MANAGE_T *hall_sw_mag = (HALL_SW_MANAGE_T *)tuya_ble_malloc(SIZEOF(HALL_SW_MANAGE_T));
     if (NULL == hall_sw_mag) {
         return HSW_ERR_MALLOC_FAILED;
     }
+    memset(hall_sw_mag, 0, SIZEOF(HALL_SW_MANAGE_T));
     hall_sw_mag->def = hsw_def;
+    hall_sw_mag->stat = &sg_hsw_stat;
+    __hall_sw_update_invalid_intv(hall_sw_mag);
 
     /* update hall sw manage list */
     if (sg_hsw_mag_list) {
         hall_sw_mag->next = sg_hsw_mag_list;
     }
     sg_hsw_mag_list = hall_sw_mag;
+    sg_hsw_port_tbl[hsw_def->port] = hall_sw_mag;
 
     /* gpio init */
-    __hall_sw_gpio_init(hsw_def->port, hsw_def->active_low);
+    __hall_sw_gpio_init(hall_sw_mag);
 
     return HSW_OK;
 }
@@ -95,26 +216,218 @@ HSW_RET tuya_hall_sw_reset(VOID_T)
         return HSW_ERR_CB_UNDEFINED;
     }
     while (hsw_mag_tmp) {
-        __hall_sw_gpio_init(hsw_mag_tmp->def->port, hsw_mag_tmp->def->active_low);
+        __hall_sw_gpio_init(hsw_mag_tmp);
         hsw_mag_tmp = hsw_mag_tmp->next;
     }
     return HSW_OK;
 }
 
 /**
- * @brief hall switch trigger handler
+ * @brief sort the classifier window
  * @param[in] hsw_mag: hall switch management
+ * @param[out] sorted: sorted intervals, HALL_SW_CLS_WIN_SIZE elements
  * @return none
  */
-STATIC VOID_T __hall_sw_trigger_handler(IN HALL_SW_MANAGE_T *hsw_mag)
+STATIC VOID_T __hall_sw_cls_sort(IN HALL_SW_MANAGE_T *hsw_mag, OUT UINT_T *sorted)
+{
+    UCHAR_T i, j;
+    UINT_T tmp;
+
+    for (i = 0; i < HALL_SW_CLS_WIN_SIZE; i++) {
+        tmp = hsw_mag->cls_win[i];
+        for (j = i; (j > 0) && (sorted[j - 1] > tmp); j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = tmp;
+    }
+}
+
+/**
+ * @brief classify an edge by its interval, credit the edges of a steady rotation
+ * @param[inout] hsw_mag: hall switch management
+ * @param[in] tm: clock time of the edge
+ * @param[in] intv: interval from the last valid edge (tick)
+ * @return count of edges credited as rotations
+ */
+STATIC UCHAR_T __hall_sw_classify(INOUT HALL_SW_MANAGE_T *hsw_mag, IN CONST UINT_T tm, IN CONST UINT_T intv)
+{
+    UINT_T sorted[HALL_SW_CLS_WIN_SIZE];
+    UINT_T median;
+    UCHAR_T credit;
+
+    /* a long pause restarts the rotation, wait for a new steady window */
+    if (intv > (HALL_SW_PERIOD_MAX_MS * 1000 * TY_CLOCK_TICK_PER_US)) {
+        hsw_mag->wk_tm = tm;
+        hsw_mag->cls_cnt = 0;
+        hsw_mag->cls_pending = 1;
+        __hall_sw_update_period(hsw_mag, intv);
+        return 0;
+    }
+    /* glitch: much shorter than the recent median, keep measuring from the last valid edge */
+    if (hsw_mag->cls_cnt == HALL_SW_CLS_WIN_SIZE) {
+        __hall_sw_cls_sort(hsw_mag, sorted);
+        median = sorted[HALL_SW_CLS_WIN_SIZE / 2];
+        if (intv < (median >> HALL_SW_CLS_GLITCH_SHIFT)) {
+            hsw_mag->stat->rejected_cnt++;
+            return 0;
+        }
+    }
+    hsw_mag->wk_tm = tm;
+    hsw_mag->cls_win[hsw_mag->cls_idx] = intv;
+    hsw_mag->cls_idx = (hsw_mag->cls_idx + 1) % HALL_SW_CLS_WIN_SIZE;
+    if (hsw_mag->cls_cnt < HALL_SW_CLS_WIN_SIZE) {
+        hsw_mag->cls_cnt++;
+        hsw_mag->cls_pending++;
+        if (hsw_mag->cls_cnt < HALL_SW_CLS_WIN_SIZE) {
+            return 0;
+        }
+    } else {
+        hsw_mag->cls_pending = 1;
+    }
+    /* irregular motion such as carrying the hoop: spread of the window is too large */
+    __hall_sw_cls_sort(hsw_mag, sorted);
+    median = sorted[HALL_SW_CLS_WIN_SIZE / 2];
+    if ((sorted[HALL_SW_CLS_WIN_SIZE * 3 / 4] - sorted[HALL_SW_CLS_WIN_SIZE / 4]) > (median >> HALL_SW_CLS_SPREAD_SHIFT)) {
+        hsw_mag->stat->rejected_cnt += hsw_mag->cls_pending;
+        hsw_mag->cls_pending = 0;
+        return 0;
+    }
+    /* steady rotation, credit this edge and the edges held while the window was filling */
+    if (hsw_mag->period_avg == 0) {
+        hsw_mag->period_avg = median << HALL_SW_PERIOD_FRAC_BITS;
+    } else {
+        __hall_sw_update_period(hsw_mag, intv);
+    }
+    credit = hsw_mag->cls_pending;
+    hsw_mag->cls_pending = 0;
+    hsw_mag->stat->accepted_cnt += credit;
+    return credit;
+}
+
+/**
+ * @brief get the clock time of an edge held in the classifier window
+ * @param[in] hsw_mag: hall switch management
+ * @param[in] tm: clock time of the last edge
+ * @param[in] back: edges back from the last edge
+ * @return clock time of the edge
+ */
+STATIC UINT_T __hall_sw_held_edge_tm(IN HALL_SW_MANAGE_T *hsw_mag, IN CONST UINT_T tm, IN UCHAR_T back)
+{
+    UINT_T edge_tm = tm;
+    UCHAR_T idx = hsw_mag->cls_idx;
+
+    /* the window keeps the intervals of the latest edges, walk back from the newest one */
+    if (back > hsw_mag->cls_cnt) {
+        back = hsw_mag->cls_cnt;
+    }
+    while (back--) {
+        idx = (idx + HALL_SW_CLS_WIN_SIZE - 1) % HALL_SW_CLS_WIN_SIZE;
+        edge_tm -= hsw_mag->cls_win[idx];
+    }
+    return edge_tm;
+}
+
+/**
+ * @brief hall switch trigger handler
+ * @param[in] hsw_mag: hall switch management
+ * @param[in] tm: clock time of the edge
+ * @return count of edges credited as rotations
+ */
+STATIC UCHAR_T __hall_sw_trigger_handler(IN HALL_SW_MANAGE_T *hsw_mag, IN CONST UINT_T tm)
 {
+    UINT_T intv = tm - hsw_mag->wk_tm;
+    UCHAR_T credit, i;
+
     /* interval detection between two triggers */
-    if (!tuya_is_clock_time_exceed(hsw_mag->wk_tm, hsw_mag->def->invalid_intv)) {
+    if (intv <= hsw_mag->invalid_tick) {
+        hsw_mag->stat->rejected_cnt++;
+        return 0;
+    }
+    /* reject outliers relative to recent periods, adapt the invalid interval */
+    credit = __hall_sw_classify(hsw_mag, tm, intv);
+    __hall_sw_update_invalid_intv(hsw_mag);
+    /* callback, edges held while the window was filling are reported oldest first with their own time */
+    for (i = credit; i > 0; i--) {
+        hsw_mag->def->hall_sw_cb(__hall_sw_held_edge_tm(hsw_mag, tm, i - 1));
+    }
+    return credit;
+}
+
+/**
+ * @brief record the latency from wakeup to the first edge taken by the main loop, called before it is classified
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __hall_sw_wake_latency_update(VOID_T)
+{
+    if (!sg_hsw_wake_pending) {
+        return;
+    }
+    sg_hsw_wake_pending = FALSE;
+    sg_hsw_wake_hold = TRUE;
+    sg_hsw_wake_deq_tm = tuya_get_clock_time();
+    sg_hsw_stat.wake_latency_last = (sg_hsw_wake_deq_tm - sg_hsw_wake_tm) / TY_CLOCK_TICK_PER_US;
+    if (sg_hsw_stat.wake_latency_last > sg_hsw_stat.wake_latency_max) {
+        sg_hsw_stat.wake_latency_max = sg_hsw_stat.wake_latency_last;
+    }
+}
+
+/**
+ * @brief record the classifier hold from that edge to the first count, called after a live edge is credited
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __hall_sw_wake_hold_update(VOID_T)
+{
+    UINT_T hold;
+
+    if (!sg_hsw_wake_hold) {
+        return;
+    }
+    sg_hsw_wake_hold = FALSE;
+    hold = (tuya_get_clock_time() - sg_hsw_wake_deq_tm) / TY_CLOCK_TICK_PER_US;
+    /* a count this late belongs to a later start of rotation, not to the wakeup */
+    if (hold > HALL_SW_WAKE_HOLD_MAX_MS * 1000) {
         return;
     }
-    hsw_mag->wk_tm = tuya_get_clock_time();
-    /* callback */
-    hsw_mag->def->hall_sw_cb();
+    sg_hsw_stat.wake_hold_last = hold;
+    if (hold > sg_hsw_stat.wake_hold_max) {
+        sg_hsw_stat.wake_hold_max = hold;
+    }
+}
+
+/**
+ * @brief put an entry into the edge queue, called in irq context
+ * @param[in] hsw_mag: hall switch management
+ * @param[in] tm: clock time of the edge
+ * @return TRUE - queued, FALSE - queue full
+ */
+STATIC BOOL_T __hall_sw_queue_put(IN HALL_SW_MANAGE_T *hsw_mag, IN CONST UINT_T tm)
+{
+    /* irqs do not nest, so the gpio and timer irq handlers are never producers at the same time */
+    UCHAR_T head = sg_hsw_edge_queue.head;
+
+    if ((UCHAR_T)(head - sg_hsw_edge_queue.tail) >= HALL_SW_EDGE_QUEUE_SIZE) {
+        return FALSE;
+    }
+    sg_hsw_edge_queue.buf[head & HALL_SW_EDGE_QUEUE_MASK].hsw_mag = hsw_mag;
+    sg_hsw_edge_queue.buf[head & HALL_SW_EDGE_QUEUE_MASK].tm = tm;
+    sg_hsw_edge_queue.head = head + 1;
+    return TRUE;
+}
+
+/**
+ * @brief push an edge into the edge queue, called in irq context
+ * @param[in] hsw_mag: hall switch management
+ * @param[in] tm: clock time of the edge
+ * @return none
+ */
+STATIC VOID_T __hall_sw_edge_push(IN HALL_SW_MANAGE_T *hsw_mag, IN CONST UINT_T tm)
+{
+    sg_hsw_stat.edge_cnt++;
+    if (!__hall_sw_queue_put(hsw_mag, tm)) {
+        sg_hsw_stat.overflow_cnt++;
+    }
 }
 
 /**
@@ -123,13 +436,359 @@ STATIC VOID_T __hall_sw_trigger_handler(IN HALL_SW_MANAGE_T *hsw_mag)
  * @return none
  */
 STATIC VOID_T __hall_sw_irq_handler(TY_GPIO_PORT_E port)
+{
+    if (sg_hsw_port_tbl[port]) {
+        __hall_sw_edge_push(sg_hsw_port_tbl[port], tuya_get_clock_time());
+    }
+}
+
+/**
+ * @brief set hall switch as pad wakeup source, called before sleep
+ * @param[in] none
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_set_wakeup(VOID_T)
 {
     HALL_SW_MANAGE_T *hsw_mag_tmp = sg_hsw_mag_list;
+    if (NULL == hsw_mag_tmp) {
+        return HSW_ERR_CB_UNDEFINED;
+    }
     while (hsw_mag_tmp) {
-        if (hsw_mag_tmp->def->port == port) {
-            __hall_sw_trigger_handler(hsw_mag_tmp);
-            break;
+        /* wake up on the next level change, so a magnet parked at the sensor does not hold the cpu awake */
+        hsw_mag_tmp->wake_level = !tuya_gpio_read(hsw_mag_tmp->def->port);
+        tuya_gpio_set_wakeup(hsw_mag_tmp->def->port, hsw_mag_tmp->wake_level, TRUE);
+        hsw_mag_tmp = hsw_mag_tmp->next;
+    }
+    return HSW_OK;
+}
+
+/**
+ * @brief hall switch wakeup handler, called as early as possible after pad wakeup
+ * @param[in] none
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_wakeup_handler(VOID_T)
+{
+    BOOL_T active_level;
+    UINT_T tm = tuya_get_clock_time();
+    HALL_SW_MANAGE_T *hsw_mag_tmp = sg_hsw_mag_list;
+    if (NULL == hsw_mag_tmp) {
+        return HSW_ERR_CB_UNDEFINED;
+    }
+    /* the pad edge itself is not timestamped, the handler time is the earliest one available */
+    sg_hsw_wake_tm = tm;
+    sg_hsw_wake_pending = FALSE;
+    sg_hsw_wake_hold = FALSE;
+    while (hsw_mag_tmp) {
+        /* only a hall pin sitting at its wake level can have woken the cpu, other pads (keys) are not measured */
+        if (tuya_gpio_read(hsw_mag_tmp->def->port) == hsw_mag_tmp->wake_level) {
+            sg_hsw_wake_pending = TRUE;
         }
+        tuya_gpio_set_wakeup(hsw_mag_tmp->def->port, hsw_mag_tmp->wake_level, FALSE);
+        /* the edge that woke the cpu is still at the active level, credit it before the irq is enabled */
+        active_level = !hsw_mag_tmp->def->active_low;
+        if ((hsw_mag_tmp->wake_level == active_level) &&
+            (tuya_gpio_read(hsw_mag_tmp->def->port) == active_level)) {
+            __hall_sw_edge_push(hsw_mag_tmp, tm);
+            sg_hsw_stat.wake_edge_cnt++;
+        }
+        __hall_sw_gpio_init(hsw_mag_tmp);
         hsw_mag_tmp = hsw_mag_tmp->next;
     }
+    return HSW_OK;
+}
+
+/**
+ * @brief record an edge into the trace ring
+ * @param[in] tm: clock time of the edge
+ * @return none
+ */
+STATIC VOID_T __hall_sw_trace_record(IN CONST UINT_T tm)
+{
+    UINT_T intv = (tm - sg_hsw_trace.last_tm) >> HALL_SW_TRACE_UNIT_SHIFT;
+
+    if ((sg_hsw_trace.num == 0) || (intv > HALL_SW_TRACE_INTV_MAX)) {
+        intv = HALL_SW_TRACE_INTV_MAX;
+    }
+    sg_hsw_trace.last_tm = tm;
+    sg_hsw_trace.intv[sg_hsw_trace.head] = (USHORT_T)intv;
+    sg_hsw_trace.head = (sg_hsw_trace.head + 1) & HALL_SW_TRACE_MASK;
+    if (sg_hsw_trace.num < HALL_SW_TRACE_SIZE) {
+        sg_hsw_trace.num++;
+    }
+}
+
+/**
+ * @brief get the number of edges in the trace ring
+ * @param[in] none
+ * @return number of edges
+ */
+USHORT_T tuya_hall_sw_trace_get_num(VOID_T)
+{
+    return sg_hsw_trace.num;
+}
+
+/**
+ * @brief read the edge trace
+ * @param[in] idx: index of the first edge to read, 0 is the oldest edge
+ * @param[out] buf: output buffer, 2 bytes per edge
+ * @param[in] max_num: maximum number of edges to read
+ * @return number of edges read
+ */
+USHORT_T tuya_hall_sw_trace_read(IN CONST USHORT_T idx, OUT UCHAR_T *buf, IN CONST USHORT_T max_num)
+{
+    USHORT_T i, pos, num;
+
+    if ((NULL == buf) || (idx >= sg_hsw_trace.num)) {
+        return 0;
+    }
+    num = sg_hsw_trace.num - idx;
+    if (num > max_num) {
+        num = max_num;
+    }
+    pos = (sg_hsw_trace.head - sg_hsw_trace.num + idx) & HALL_SW_TRACE_MASK;
+    for (i = 0; i < num; i++) {
+        *buf++ = (UCHAR_T)(sg_hsw_trace.intv[pos] >> 8);
+        *buf++ = (UCHAR_T)(sg_hsw_trace.intv[pos]);
+        pos = (pos + 1) & HALL_SW_TRACE_MASK;
+    }
+    return num;
+}
+
+/**
+ * @brief replay an edge trace through the edge processing, as fast as possible
+ * @param[in] port: hall switch port, its define gives the filter parameters
+ * @param[in] trace: trace data in the format of tuya_hall_sw_trace_read()
+ * @param[in] num: number of edges
+ * @param[in] restart: TRUE - reset the replay state first, FALSE - continue the previous replay
+ * @param[in] replay_cb: called for every edge credited as a rotation, instead of the live callback
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_trace_replay(IN CONST TY_GPIO_PORT_E port, IN CONST UCHAR_T *trace, IN CONST USHORT_T num,
+                                  IN CONST BOOL_T restart, IN CONST HALL_SW_CALLBACK replay_cb)
+{
+    USHORT_T i, intv;
+
+    if ((NULL == trace) || (NULL == replay_cb) || (port >= TY_GPIO_MAX) || (NULL == sg_hsw_port_tbl[port])) {
+        return HSW_ERR_INVALID_PARM;
+    }
+    /* edges carry synthesized clock times on a private manager, the result only depends on the trace */
+    if (restart || (NULL == sg_hsw_replay_mag.def) || (sg_hsw_replay_def.port != port)) {
+        memcpy(&sg_hsw_replay_def, sg_hsw_port_tbl[port]->def, SIZEOF(HALL_SW_DEF_T));
+        memset(&sg_hsw_replay_mag, 0, SIZEOF(HALL_SW_MANAGE_T));
+        sg_hsw_replay_mag.def = &sg_hsw_replay_def;
+        sg_hsw_replay_mag.stat = &sg_hsw_replay_stat;
+        memset((VOID_T *)&sg_hsw_replay_stat, 0, SIZEOF(HALL_SW_STAT_T));
+        sg_hsw_replay_tm = 0;
+        __hall_sw_update_invalid_intv(&sg_hsw_replay_mag);
+    }
+    sg_hsw_replay_def.hall_sw_cb = replay_cb;
+    for (i = 0; i < num; i++) {
+        intv = ((USHORT_T)trace[2 * i] << 8) | trace[2 * i + 1];
+        sg_hsw_replay_tm += (UINT_T)intv << HALL_SW_TRACE_UNIT_SHIFT;
+        sg_hsw_replay_stat.edge_cnt++;
+        __hall_sw_trigger_handler(&sg_hsw_replay_mag, sg_hsw_replay_tm);
+    }
+    return HSW_OK;
+}
+
+/**
+ * @brief queue test producer, pushes numbered entries in the timer irq
+ * @param[in] none
+ * @return 0
+ */
+STATIC INT_T __hall_sw_qtest_timer_cb(VOID_T)
+{
+    UCHAR_T i;
+
+    for (i = 0; (i < sg_hsw_qtest.burst) && (sg_hsw_qtest.seq < sg_hsw_qtest.res.num); i++) {
+        if (__hall_sw_queue_put(&sg_hsw_qtest_mag, sg_hsw_qtest.seq)) {
+            sg_hsw_qtest.res.pushed++;
+        } else {
+            sg_hsw_qtest.res.overflow++;
+        }
+        sg_hsw_qtest.seq++;
+    }
+    if (sg_hsw_qtest.seq >= sg_hsw_qtest.res.num) {
+        tuya_hardware_timer_delete(sg_hsw_qtest.timer);
+        sg_hsw_qtest.producing = FALSE;
+    }
+    return 0;
+}
+
+/**
+ * @brief queue test consumer, checks the sequence number of a popped entry
+ * @param[in] seq: sequence number
+ * @return none
+ */
+STATIC VOID_T __hall_sw_qtest_pop(IN CONST UINT_T seq)
+{
+    sg_hsw_qtest.res.popped++;
+    if (seq < sg_hsw_qtest.expect) {
+        sg_hsw_qtest.res.disorder++;
+        return;
+    }
+    /* a skipped number is only allowed where the producer saw the queue full */
+    sg_hsw_qtest.res.lost += seq - sg_hsw_qtest.expect;
+    sg_hsw_qtest.expect = seq + 1;
+}
+
+/**
+ * @brief finish the queue test once the last push is drained, called in main loop
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __hall_sw_qtest_check_done(VOID_T)
+{
+    HALL_SW_QTEST_T res;
+
+    /* producing is read before the queue, so no push can come after the queue is seen empty */
+    if (!sg_hsw_qtest.running || sg_hsw_qtest.producing || (sg_hsw_edge_queue.tail != sg_hsw_edge_queue.head)) {
+        return;
+    }
+    sg_hsw_qtest.running = FALSE;
+    /* numbers after the last popped one were refused at the end of the test */
+    sg_hsw_qtest.res.lost += sg_hsw_qtest.res.num - sg_hsw_qtest.expect;
+    memcpy(&res, (VOID_T *)&sg_hsw_qtest.res, SIZEOF(HALL_SW_QTEST_T));
+    res.pass = ((res.pushed + res.overflow) == res.num) && (res.popped == res.pushed) &&
+               (res.lost == res.overflow) && (res.disorder == 0);
+    sg_hsw_qtest.done_cb(&res);
+}
+
+/**
+ * @brief start the edge queue stress test, a hardware timer irq pushes numbered entries while the main loop pops them
+ * @param[in] timer: free hardware timer used as the producer
+ * @param[in] intv_us: interval of the timer irq (us)
+ * @param[in] burst: entries pushed in one timer irq
+ * @param[in] num: total entries to push
+ * @param[in] done_cb: called in main loop when the queue is drained after the last push
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_queue_test_start(IN CONST TY_HW_TIMER_TYPE_E timer, IN CONST UINT_T intv_us, IN CONST UCHAR_T burst,
+                                      IN CONST UINT_T num, IN CONST HALL_SW_QTEST_CALLBACK done_cb)
+{
+    if ((NULL == done_cb) || (intv_us == 0) || (burst == 0) || (num == 0)) {
+        return HSW_ERR_INVALID_PARM;
+    }
+    if (sg_hsw_qtest.running) {
+        return HSW_ERR_BUSY;
+    }
+    memset((VOID_T *)&sg_hsw_qtest, 0, SIZEOF(HALL_SW_QTEST_STATE_T));
+    sg_hsw_qtest.res.num = num;
+    sg_hsw_qtest.done_cb = done_cb;
+    sg_hsw_qtest.timer = timer;
+    sg_hsw_qtest.burst = burst;
+    sg_hsw_qtest.producing = TRUE;
+    sg_hsw_qtest.running = TRUE;
+    if (TIMER_OK != tuya_hardware_timer_create(timer, intv_us, __hall_sw_qtest_timer_cb, TY_TIMER_REPEAT)) {
+        sg_hsw_qtest.running = FALSE;
+        return HSW_ERR_BUSY;
+    }
+    return HSW_OK;
+}
+
+/**
+ * @brief hall switch edge process, must be called in main loop
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_hall_sw_loop(VOID_T)
+{
+    volatile HALL_SW_EDGE_T *edge;
+    UCHAR_T tail = sg_hsw_edge_queue.tail;
+    UCHAR_T depth = (UCHAR_T)(sg_hsw_edge_queue.head - tail);
+
+    if (depth > sg_hsw_stat.max_depth) {
+        sg_hsw_stat.max_depth = depth;
+    }
+    if (sg_hsw_qtest.running && (depth > sg_hsw_qtest.res.max_depth)) {
+        sg_hsw_qtest.res.max_depth = depth;
+    }
+    while (tail != sg_hsw_edge_queue.head) {
+        edge = &sg_hsw_edge_queue.buf[tail & HALL_SW_EDGE_QUEUE_MASK];
+        if (edge->hsw_mag == &sg_hsw_qtest_mag) {
+            __hall_sw_qtest_pop(edge->tm);
+        } else {
+            __hall_sw_trace_record(edge->tm);
+            __hall_sw_wake_latency_update();
+            if (__hall_sw_trigger_handler(edge->hsw_mag, edge->tm)) {
+                __hall_sw_wake_hold_update();
+            }
+        }
+        tail++;
+        sg_hsw_edge_queue.tail = tail;
+    }
+    __hall_sw_qtest_check_done();
+}
+
+/**
+ * @brief get the average rotation period of hall switch
+ * @param[in] port: hall switch port
+ * @return average rotation period (us), 0 means unknown
+ */
+UINT_T tuya_hall_sw_get_period(IN CONST TY_GPIO_PORT_E port)
+{
+    if ((port >= TY_GPIO_MAX) || (NULL == sg_hsw_port_tbl[port])) {
+        return 0;
+    }
+    /* TY_CLOCK_TICK_PER_US is 16, so tick(Q4) to us is a shift */
+    return (sg_hsw_port_tbl[port]->period_avg >> (HALL_SW_PERIOD_FRAC_BITS + 4));
+}
+
+/**
+ * @brief get the average rotation period learned by the trace replay
+ * @param[in] none
+ * @return average rotation period (us), 0 means unknown
+ */
+UINT_T tuya_hall_sw_get_replay_period(VOID_T)
+{
+    return (sg_hsw_replay_mag.period_avg >> (HALL_SW_PERIOD_FRAC_BITS + 4));
+}
+
+/**
+ * @brief copy hall switch statistics
+ * @param[in] src: statistics to copy
+ * @param[out] stat: hall switch statistics
+ * @return none
+ */
+STATIC VOID_T __hall_sw_stat_copy(IN volatile HALL_SW_STAT_T *src, OUT HALL_SW_STAT_T *stat)
+{
+    stat->edge_cnt = src->edge_cnt;
+    stat->overflow_cnt = src->overflow_cnt;
+    stat->max_depth = src->max_depth;
+    stat->accepted_cnt = src->accepted_cnt;
+    stat->rejected_cnt = src->rejected_cnt;
+    stat->wake_edge_cnt = src->wake_edge_cnt;
+    stat->wake_latency_last = src->wake_latency_last;
+    stat->wake_latency_max = src->wake_latency_max;
+    stat->wake_hold_last = src->wake_hold_last;
+    stat->wake_hold_max = src->wake_hold_max;
+}
+
+/**
+ * @brief get hall switch statistics
+ * @param[out] stat: hall switch statistics
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_get_stat(OUT HALL_SW_STAT_T *stat)
+{
+    if (NULL == stat) {
+        return HSW_ERR_INVALID_PARM;
+    }
+    __hall_sw_stat_copy(&sg_hsw_stat, stat);
+    return HSW_OK;
+}
+
+/**
+ * @brief get the statistics of the trace replay since its last restart
+ * @param[out] stat: replay statistics
+ * @return HSW_RET
+ */
+HSW_RET tuya_hall_sw_get_replay_stat(OUT HALL_SW_STAT_T *stat)
+{
+    if (NULL == stat) {
+        return HSW_ERR_INVALID_PARM;
+    }
+    __hall_sw_stat_copy(&sg_hsw_replay_stat, stat);
+    return HSW_OK;
 }
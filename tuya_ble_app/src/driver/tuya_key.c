@@ -18,35 +18,105 @@
 ***********************************************************/
 #define KEY_SCAN_CYCLE_MS       10
 #define KEY_PRESS_SHORT_TIME    50
+#define KEY_SCAN_STOP           (-1)    /* return value that removes the software timer */
+#define KEY_EVENT_QUEUE_SIZE    8       /* must be a power of 2 */
+#define KEY_EVENT_QUEUE_MASK    (KEY_EVENT_QUEUE_SIZE - 1)
+#define KEY_EDGE_AGE_MAX_MS     50      /* an older press edge does not belong to the detected press */
+#define KEY_LATENCY_SLOT_NONE   0xFF
 
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
-/* Key status */
+/* Key threshold, precompiled at registration */
 typedef struct {
-    BOOL_T cur_stat;
-    BOOL_T prv_stat;
-    UINT_T cur_time;
-    UINT_T prv_time;
-} KEY_STATUS_T;
+    UINT_T time;                /* hold time that reaches the threshold (ms) */
+    KEY_PRESS_TYPE_E type;      /* event type of the threshold */
+} KEY_THRESHOLD_T;
 
 /* Key manage */
 typedef struct key_manage_s {
     struct key_manage_s *next;
     KEY_DEF_T *key_def_s;
-    KEY_STATUS_T key_status_s;
+    KEY_THRESHOLD_T thld[KEY_LONG_PRESS_NUM + 1];   /* short press and hold thresholds, ascending */
+    UCHAR_T thld_num;
+    BOOL_T hold_fire;           /* the last threshold fires while held, others fire on release */
+    UCHAR_T group;              /* gpio group of the key port */
+    UCHAR_T bit;                /* bit mask of the key port in the group */
+    BOOL_T pressed;
+    BOOL_T suppressed;          /* events taken by a chord, until release */
+    UCHAR_T reached;            /* thresholds reached by the current press */
+    UINT_T press_time;          /* hold time of the current press (ms) */
+    UINT_T dbl_wait;            /* remaining double press window (ms), 0 - closed */
+    UINT_T dbl_lag;             /* press lag of the short press held in the double press window (tick) */
+    volatile UINT_T edge_tm;    /* clock time of the press edge, written by irq */
+    volatile BOOL_T edge_valid;
+    UINT_T press_lag;           /* from the press edge to its detection (tick), 0 - unknown */
 } KEY_MANAGE_T;
 
+/* Key chord manage */
+typedef struct key_chord_manage_s {
+    struct key_chord_manage_s *next;
+    KEY_CHORD_DEF_T *chord_def_s;
+    KEY_MANAGE_T *key_mag[2];
+    BOOL_T fired;               /* fired during the current common press */
+} KEY_CHORD_MANAGE_T;
+
+typedef struct {
+    KEY_CALLBACK key_cb;        /* callback of the key or chord */
+    TY_GPIO_PORT_E port;        /* key port, first key port for chords */
+    KEY_PRESS_TYPE_E type;      /* event type */
+    UINT_T tm;                  /* clock time of the detection */
+    UINT_T lag;                 /* from the press edge to its detection (tick) */
+} KEY_EVENT_T;
+
+typedef struct {
+    KEY_EVENT_T buf[KEY_EVENT_QUEUE_SIZE];
+    UCHAR_T head;               /* written by the scan timer only */
+    UCHAR_T tail;               /* written by the main loop only */
+} KEY_EVENT_QUEUE_T;
+
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
 STATIC KEY_MANAGE_T *sg_key_mag_list = NULL;
+STATIC KEY_CHORD_MANAGE_T *sg_key_chord_list = NULL;
+STATIC UCHAR_T sg_key_group_used = 0;               /* gpio groups that have keys, bit n is group n */
+STATIC BOOL_T sg_key_scan_active = FALSE;           /* scan timer is running */
+STATIC volatile BOOL_T sg_key_edge_flag = FALSE;    /* press edge detected by irq */
+STATIC KEY_EVENT_QUEUE_T sg_key_event_queue;
+STATIC KEY_STAT_T sg_key_stat;
+STATIC KEY_MANAGE_T *sg_key_port_tbl[TY_GPIO_MAX];  /* key indexed by port, for the irq handler */
+STATIC KEY_LATENCY_STAT_T sg_key_latency[KEY_LATENCY_SLOT_NUM];
+STATIC UCHAR_T sg_key_latency_num = 0;
+STATIC UCHAR_T sg_key_disp_slot = KEY_LATENCY_SLOT_NONE;    /* slot waiting for the display refresh */
+STATIC UINT_T sg_key_disp_base = 0;                 /* clock time the latency of that slot counts from */
+STATIC UINT_T sg_key_wake_tm = 0;                   /* clock time of the last pad wakeup */
+STATIC BOOL_T sg_key_wake_pending = FALSE;          /* wakeup not yet applied by tuya_key_reset() */
 
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
 STATIC INT_T __key_timeout_handler(VOID_T);
 
+/**
+ * @brief key irq handler, only flags the press edge, scanning is started in main loop
+ * @param[in] port: gpio number
+ * @return none
+ */
+STATIC VOID_T __key_irq_handler(TY_GPIO_PORT_E port)
+{
+    KEY_MANAGE_T *key_mag = sg_key_port_tbl[port];
+    UINT_T tm = tuya_get_clock_time();
+
+    /* keep the first edge of a press, bounces and stale edges are skipped */
+    if ((key_mag) && (!key_mag->pressed) &&
+        ((!key_mag->edge_valid) || ((tm - key_mag->edge_tm) > KEY_EDGE_AGE_MAX_MS * 1000 * TY_CLOCK_TICK_PER_US))) {
+        key_mag->edge_tm = tm;
+        key_mag->edge_valid = TRUE;
+    }
+    sg_key_edge_flag = TRUE;
+}
+
 /**
  * @brief key gpio init
  * @param[in] pin: pin number
@@ -56,6 +126,82 @@ STATIC INT_T __key_timeout_handler(VOID_T);
 STATIC VOID_T __key_gpio_init(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T active_low)
 {
     tuya_gpio_init(port, TRUE, active_low);
+    /* the press edge wakes up the scan timer */
+    tuya_gpio_irq_init(port, (active_low ? TY_GPIO_IRQ_FALLING : TY_GPIO_IRQ_RISING), __key_irq_handler);
+}
+
+/**
+ * @brief start the key scan timer if it is not running
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __key_scan_start(VOID_T)
+{
+    if (sg_key_scan_active) {
+        return;
+    }
+    if (TIMER_OK == tuya_software_timer_create(KEY_SCAN_CYCLE_MS*1000, __key_timeout_handler)) {
+        sg_key_scan_active = TRUE;
+    }
+}
+
+/**
+ * @brief precompile the thresholds of a key into an ascending table
+ * @param[inout] key_mag: key manage information
+ * @return none
+ */
+STATIC VOID_T __key_compile_threshold(INOUT KEY_MANAGE_T *key_mag)
+{
+    UINT_T time[KEY_LONG_PRESS_NUM];
+    UCHAR_T i, j;
+
+    time[0] = key_mag->key_def_s->long_press_time1;
+    time[1] = key_mag->key_def_s->long_press_time2;
+    time[2] = key_mag->key_def_s->long_press_time3;
+    time[3] = key_mag->key_def_s->long_press_time4;
+
+    key_mag->thld[0].time = KEY_PRESS_SHORT_TIME;
+    key_mag->thld[0].type = SHORT_PRESS;
+    key_mag->thld_num = 1;
+    for (i = 0; i < KEY_LONG_PRESS_NUM; i++) {
+        if (time[i] <= KEY_PRESS_SHORT_TIME) {
+            continue;
+        }
+        /* a threshold equal to an existing one is ignored */
+        for (j = 0; j < key_mag->thld_num; j++) {
+            if (key_mag->thld[j].time == time[i]) {
+                break;
+            }
+        }
+        if (j < key_mag->thld_num) {
+            continue;
+        }
+        /* insertion sort */
+        for (j = key_mag->thld_num; (j > 0) && (key_mag->thld[j-1].time > time[i]); j--) {
+            key_mag->thld[j] = key_mag->thld[j-1];
+        }
+        key_mag->thld[j].time = time[i];
+        key_mag->thld[j].type = LONG_PRESS_FOR_TIME1 + i;
+        key_mag->thld_num++;
+    }
+    /* a lone short press waits for the release when double press is enabled */
+    key_mag->hold_fire = ((key_mag->thld_num > 1) || (key_mag->key_def_s->double_press_time == 0)) ? TRUE : FALSE;
+}
+
+/**
+ * @brief clear the press status of a key
+ * @param[inout] key_mag: key manage information
+ * @return none
+ */
+STATIC VOID_T __key_clear_status(INOUT KEY_MANAGE_T *key_mag)
+{
+    key_mag->pressed = FALSE;
+    key_mag->suppressed = FALSE;
+    key_mag->reached = 0;
+    key_mag->press_time = 0;
+    key_mag->dbl_wait = 0;
+    key_mag->edge_valid = FALSE;
+    key_mag->press_lag = 0;
 }
 
 /**
@@ -69,24 +215,33 @@ KEY_RET tuya_reg_key(IN KEY_DEF_T *key_def)
     if (key_def->key_cb == NULL) {
         return KEY_ERR_CB_UNDEFINED;
     }
+    if (key_def->port >= TY_GPIO_MAX) {
+        return KEY_ERR_INVALID_PARM;
+    }
 
     /* allocate and clear for key_mag */
     KEY_MANAGE_T *key_mag = (KEY_MANAGE_T *)tuya_ble_malloc(SIZEOF(KEY_MANAGE_T));
     if (NULL == key_mag) {
         return KEY_ERR_MALLOC_FAILED;
     }
+    memset(key_mag, 0, SIZEOF(KEY_MANAGE_T));
 
     /* update key manage list */
     key_mag->key_def_s = key_def;
+    __key_compile_threshold(key_mag);
+    key_mag->group = TY_GPIO_GROUP(key_def->port);
+    key_mag->bit = TY_GPIO_BIT(key_def->port);
+    sg_key_group_used |= (1 << key_mag->group);
     if (sg_key_mag_list) {
     	key_mag->next = sg_key_mag_list;
-    } else {
-        tuya_software_timer_create(KEY_SCAN_CYCLE_MS*1000, __key_timeout_handler);
     }
     sg_key_mag_list = key_mag;
+    sg_key_port_tbl[key_def->port] = key_mag;
 
     /* gpio init */
     __key_gpio_init(key_def->port, key_def->active_low);
+    /* scan once in case the key is already pressed, the timer stops itself when released */
+    __key_scan_start();
 
     return KEY_OK;
 }
@@ -104,180 +259,450 @@ KEY_RET tuya_key_reset(VOID_T)
     }
     while (key_mag_tmp) {
         __key_gpio_init(key_mag_tmp->key_def_s->port, key_mag_tmp->key_def_s->active_low);
+        __key_clear_status(key_mag_tmp);
+        /* a press that woke the cpu has no irq edge, its lag counts from the wakeup */
+        if ((sg_key_wake_pending) &&
+            (tuya_gpio_read(key_mag_tmp->key_def_s->port) != key_mag_tmp->key_def_s->active_low)) {
+            key_mag_tmp->edge_tm = sg_key_wake_tm;
+            key_mag_tmp->edge_valid = TRUE;
+        }
         key_mag_tmp = key_mag_tmp->next;
     }
-    tuya_software_timer_delete(__key_timeout_handler);
-    tuya_software_timer_create(KEY_SCAN_CYCLE_MS*1000, __key_timeout_handler);
+    sg_key_wake_pending = FALSE;
+    if (sg_key_scan_active) {
+        tuya_software_timer_delete(__key_timeout_handler);
+        sg_key_scan_active = FALSE;
+    }
+    __key_scan_start();
     return KEY_OK;
 }
 
 /**
- * @brief get the real-time status of the key
+ * @brief key wakeup handler, called after pad wakeup and before tuya_key_reset()
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_wakeup_handler(VOID_T)
+{
+    sg_key_wake_tm = tuya_get_clock_time();
+    sg_key_wake_pending = TRUE;
+}
+
+/**
+ * @brief find a registered key by port
  * @param[in] port: key port
- * @param[in] active_low: TURE - active low, FALSE - active high
- * @return key_stat: TRUE - press, FALSE - release
+ * @return key manage information, NULL if not registered
  */
-STATIC BOOL_T __get_key_stat(IN CONST TY_GPIO_PORT_E port, IN CONST UCHAR_T active_low)
+STATIC KEY_MANAGE_T *__key_find(IN CONST TY_GPIO_PORT_E port)
 {
-    BOOL_T key_stat;
-    if (active_low) {
-        key_stat = tuya_gpio_read(port) == 0 ? TRUE : FALSE;
-    } else {
-        key_stat = tuya_gpio_read(port) == 0 ? FALSE : TRUE;
+    if (port >= TY_GPIO_MAX) {
+        return NULL;
     }
-    return key_stat;
+    return sg_key_port_tbl[port];
 }
 
 /**
- * @brief update key status
- * @param[inout] key_mag: key manage information
- * @return none
+ * @brief key chord register, both keys must be registered before
+ * @param[in] chord_def: user key chord define
+ * @return KEY_RET
  */
-STATIC VOID_T __update_key_status(INOUT KEY_MANAGE_T *key_mag)
+KEY_RET tuya_reg_key_chord(IN KEY_CHORD_DEF_T *chord_def)
 {
-    BOOL_T key_stat;
-    /* save previous status */
-    key_mag->key_status_s.prv_stat = key_mag->key_status_s.cur_stat;
-    key_mag->key_status_s.prv_time = key_mag->key_status_s.cur_time;
-    /* get the real-time status */
-    key_stat = __get_key_stat(key_mag->key_def_s->port, key_mag->key_def_s->active_low);
-	/* update current status */
-    if (key_stat != key_mag->key_status_s.cur_stat) {
-        key_mag->key_status_s.cur_stat = key_stat;
-        key_mag->key_status_s.cur_time = 0;
-    } else {
-        key_mag->key_status_s.cur_time += KEY_SCAN_CYCLE_MS;
+    KEY_MANAGE_T *key_mag1, *key_mag2;
+
+    /* check callback function */
+    if (chord_def->key_cb == NULL) {
+        return KEY_ERR_CB_UNDEFINED;
     }
+    /* check keys */
+    key_mag1 = __key_find(chord_def->port1);
+    key_mag2 = __key_find(chord_def->port2);
+    if ((NULL == key_mag1) || (NULL == key_mag2) || (key_mag1 == key_mag2)) {
+        return KEY_ERR_INVALID_PARM;
+    }
+
+    /* allocate and clear for chord_mag */
+    KEY_CHORD_MANAGE_T *chord_mag = (KEY_CHORD_MANAGE_T *)tuya_ble_malloc(SIZEOF(KEY_CHORD_MANAGE_T));
+    if (NULL == chord_mag) {
+        return KEY_ERR_MALLOC_FAILED;
+    }
+    memset(chord_mag, 0, SIZEOF(KEY_CHORD_MANAGE_T));
+
+    /* update key chord manage list */
+    chord_mag->chord_def_s = chord_def;
+    chord_mag->key_mag[0] = key_mag1;
+    chord_mag->key_mag[1] = key_mag2;
+    chord_mag->next = sg_key_chord_list;
+    sg_key_chord_list = chord_mag;
+
+    return KEY_OK;
 }
 
 /**
- * @brief is key press over time
- * @param[in] key_status_s: key status
- * @param[in] over_time: over time used for judgment
- * @return TRUE or FALSE
+ * @brief get the latency slot of a key and event type, a new slot is taken on first use
+ * @param[in] port: key port
+ * @param[in] type: event type
+ * @return slot index, KEY_LATENCY_SLOT_NONE if all slots are taken
  */
-STATIC BOOL_T __is_key_press_over_time(IN CONST KEY_STATUS_T key_status_s, IN CONST UINT_T over_time)
+STATIC UCHAR_T __key_latency_slot(IN CONST TY_GPIO_PORT_E port, IN CONST KEY_PRESS_TYPE_E type)
 {
-    if (key_status_s.cur_stat == TRUE) {
-        if ((key_status_s.cur_time >= over_time) &&
-            (key_status_s.prv_time < over_time)) {
-            return TRUE;
+    UCHAR_T i;
+    for (i = 0; i < sg_key_latency_num; i++) {
+        if ((sg_key_latency[i].port == port) && (sg_key_latency[i].type == type)) {
+            return i;
         }
     }
-    return FALSE;
+    if (sg_key_latency_num >= KEY_LATENCY_SLOT_NUM) {
+        return KEY_LATENCY_SLOT_NONE;
+    }
+    memset(&sg_key_latency[i], 0, SIZEOF(KEY_LATENCY_STAT_T));
+    sg_key_latency[i].port = port;
+    sg_key_latency[i].type = type;
+    sg_key_latency_num++;
+    return i;
 }
 
 /**
- * @brief is key from release to release over time and less time
- * @param[in] key_status_s: key status
- * @param[in] over_time: over time used for judgment
- * @param[in] less_time: less time used for judgment
- * @return TRUE or FALSE
+ * @brief add one sample to latency counters
+ * @param[inout] lat: latency counters
+ * @param[in] tick: latency (tick)
+ * @return none
  */
-STATIC BOOL_T __is_key_release_to_release_over_time_and_less_time(IN CONST KEY_STATUS_T key_status_s, IN CONST UINT_T over_time, IN CONST UINT_T less_time)
+STATIC VOID_T __key_latency_add(INOUT KEY_LATENCY_T *lat, IN CONST UINT_T tick)
 {
-    if ((key_status_s.prv_stat == TRUE) &&
-        (key_status_s.cur_stat == FALSE)) {
-        if ((key_status_s.prv_time >= over_time) &&
-            (key_status_s.prv_time < less_time)) {
-            return TRUE;
-        }
+    UINT_T us = tick / TY_CLOCK_TICK_PER_US;
+    UINT_T ms = us / 1000;
+    UCHAR_T bucket = 0;
+
+    if ((lat->cnt == 0) || (us < lat->min)) {
+        lat->min = us;
+    }
+    if (us > lat->max) {
+        lat->max = us;
+    }
+    lat->sum += us;
+    lat->cnt++;
+    /* bucket n holds latency below (2 << n) ms */
+    while ((bucket < KEY_LATENCY_HIST_NUM - 1) && (ms >= (2UL << bucket))) {
+        bucket++;
+    }
+    if (lat->hist[bucket] < 0xFFFF) {
+        lat->hist[bucket]++;
     }
-    return FALSE;
 }
 
 /**
- * @brief detect and handle key event
- * @param[inout] key_mag: key manage information
+ * @brief key process, must be called in main loop, key callbacks are called here
+ * @param[in] none
  * @return none
  */
-STATIC VOID_T __detect_and_handle_key_event(INOUT KEY_MANAGE_T *key_mag)
+VOID_T tuya_key_loop(VOID_T)
 {
-    KEY_PRESS_TYPE_E type;
-    BOOL_T time_exchange;
-    UINT_T long_time1, long_time2;
-
-    /* compare long_time1 and long time2 */
-    if (key_mag->key_def_s->long_press_time2 >= key_mag->key_def_s->long_press_time1) {
-        long_time1 = key_mag->key_def_s->long_press_time1;
-        long_time2 = key_mag->key_def_s->long_press_time2;
-        time_exchange = FALSE;
-    } else {
-        long_time1 = key_mag->key_def_s->long_press_time2;
-        long_time2 = key_mag->key_def_s->long_press_time1;
-        time_exchange = TRUE;
-    }
-    /* judge key status */
-    if ((long_time2 != 0) && (long_time1 != 0)) {
-        if (__is_key_press_over_time(key_mag->key_status_s, long_time2)) {
-            type = LONG_PRESS_FOR_TIME2;
-            goto KEY_EVENT;
+    KEY_EVENT_T *evt;
+    UINT_T tm;
+    UCHAR_T slot;
+
+    if (sg_key_edge_flag) {
+        sg_key_edge_flag = FALSE;
+        __key_scan_start();
+    }
+    /* callbacks run here, out of the scan timer */
+    while (sg_key_event_queue.tail != sg_key_event_queue.head) {
+        evt = &sg_key_event_queue.buf[sg_key_event_queue.tail & KEY_EVENT_QUEUE_MASK];
+        tm = tuya_get_clock_time();
+        sg_key_stat.latency_last = (tm - evt->tm) / TY_CLOCK_TICK_PER_US;
+        if (sg_key_stat.latency_last > sg_key_stat.latency_max) {
+            sg_key_stat.latency_max = sg_key_stat.latency_last;
         }
-        if (__is_key_release_to_release_over_time_and_less_time(key_mag->key_status_s, long_time1, long_time2)) {
-            type = LONG_PRESS_FOR_TIME1;
-            goto KEY_EVENT;
+        /* the hold time asked by the gesture is not latency, only the press lag is added */
+        slot = __key_latency_slot(evt->port, evt->type);
+        if (slot != KEY_LATENCY_SLOT_NONE) {
+            __key_latency_add(&sg_key_latency[slot].cb, (tm - evt->tm) + evt->lag);
+            sg_key_disp_slot = slot;
+            sg_key_disp_base = evt->tm - evt->lag;
         }
-        if (__is_key_release_to_release_over_time_and_less_time(key_mag->key_status_s, KEY_PRESS_SHORT_TIME, long_time1)){
-            type = SHORT_PRESS;
-            goto KEY_EVENT;
+        evt->key_cb(evt->type);
+        sg_key_event_queue.tail++;
+    }
+}
+
+/**
+ * @brief get key statistics
+ * @param[out] stat: key statistics
+ * @return KEY_RET
+ */
+KEY_RET tuya_key_get_stat(OUT KEY_STAT_T *stat)
+{
+    if (NULL == stat) {
+        return KEY_ERR_INVALID_PARM;
+    }
+    *stat = sg_key_stat;
+    return KEY_OK;
+}
+
+/**
+ * @brief mark the display refreshed, closes the latency of the last dispatched key event
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_latency_mark_disp(VOID_T)
+{
+    if (sg_key_disp_slot == KEY_LATENCY_SLOT_NONE) {
+        return;
+    }
+    __key_latency_add(&sg_key_latency[sg_key_disp_slot].disp, tuya_get_clock_time() - sg_key_disp_base);
+    sg_key_disp_slot = KEY_LATENCY_SLOT_NONE;
+}
+
+/**
+ * @brief drop the display latency of the last dispatched key event, its action did not change the display
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_latency_cancel_disp(VOID_T)
+{
+    sg_key_disp_slot = KEY_LATENCY_SLOT_NONE;
+}
+
+/**
+ * @brief get the number of key latency statistics slots in use
+ * @param[in] none
+ * @return number of slots
+ */
+UCHAR_T tuya_key_get_latency_num(VOID_T)
+{
+    return sg_key_latency_num;
+}
+
+/**
+ * @brief get key latency statistics of one key and event type
+ * @param[in] idx: slot index
+ * @param[out] stat: latency statistics
+ * @return KEY_RET
+ */
+KEY_RET tuya_key_get_latency(IN CONST UCHAR_T idx, OUT KEY_LATENCY_STAT_T *stat)
+{
+    if ((NULL == stat) || (idx >= sg_key_latency_num)) {
+        return KEY_ERR_INVALID_PARM;
+    }
+    *stat = sg_key_latency[idx];
+    return KEY_OK;
+}
+
+/**
+ * @brief clear key latency statistics
+ * @param[in] none
+ * @return none
+ */
+VOID_T tuya_key_clear_latency(VOID_T)
+{
+    sg_key_latency_num = 0;
+    sg_key_disp_slot = KEY_LATENCY_SLOT_NONE;
+}
+
+/**
+ * @brief get the real-time status of the key from the sampled group levels
+ * @param[in] key_mag: key manage information
+ * @param[in] level: input levels of all gpio groups
+ * @return key_stat: TRUE - press, FALSE - release
+ */
+STATIC BOOL_T __get_key_stat(IN CONST KEY_MANAGE_T *key_mag, IN CONST UCHAR_T *level)
+{
+    BOOL_T high = (level[key_mag->group] & key_mag->bit) ? TRUE : FALSE;
+    return (key_mag->key_def_s->active_low) ? !high : high;
+}
+
+/**
+ * @brief sample the input levels of all gpio groups that have keys
+ * @param[out] level: input levels of all gpio groups
+ * @return none
+ */
+STATIC VOID_T __sample_key_groups(OUT UCHAR_T *level)
+{
+    UCHAR_T group;
+    for (group = 0; group < TY_GPIO_GROUP_NUM; group++) {
+        level[group] = (sg_key_group_used & (1 << group)) ? tuya_gpio_read_port(group) : 0;
+    }
+}
+
+/**
+ * @brief push a key event into the event queue, called in scan timer context
+ * @param[in] key_cb: callback of the key or chord
+ * @param[in] port: key port, first key port for chords
+ * @param[in] type: event type
+ * @param[in] lag: from the press edge to its detection (tick)
+ * @return none
+ */
+STATIC VOID_T __key_event_push(IN KEY_CALLBACK key_cb, IN CONST TY_GPIO_PORT_E port, IN CONST KEY_PRESS_TYPE_E type, IN CONST UINT_T lag)
+{
+    UCHAR_T head = sg_key_event_queue.head;
+
+    sg_key_stat.event_cnt++;
+    if ((UCHAR_T)(head - sg_key_event_queue.tail) >= KEY_EVENT_QUEUE_SIZE) {
+        sg_key_stat.overflow_cnt++;
+        return;
+    }
+    sg_key_event_queue.buf[head & KEY_EVENT_QUEUE_MASK].key_cb = key_cb;
+    sg_key_event_queue.buf[head & KEY_EVENT_QUEUE_MASK].port = port;
+    sg_key_event_queue.buf[head & KEY_EVENT_QUEUE_MASK].type = type;
+    sg_key_event_queue.buf[head & KEY_EVENT_QUEUE_MASK].tm = tuya_get_clock_time();
+    sg_key_event_queue.buf[head & KEY_EVENT_QUEUE_MASK].lag = lag;
+    sg_key_event_queue.head = head + 1;
+}
+
+/**
+ * @brief emit a key event, a pending short press is flushed before any other event
+ * @param[inout] key_mag: key manage information
+ * @param[in] type: event type
+ * @return none
+ */
+STATIC VOID_T __key_emit(INOUT KEY_MANAGE_T *key_mag, IN CONST KEY_PRESS_TYPE_E type)
+{
+    if (key_mag->dbl_wait) {
+        key_mag->dbl_wait = 0;
+        if (type == SHORT_PRESS) {
+            /* the double press is detected with the second press */
+            __key_event_push(key_mag->key_def_s->key_cb, key_mag->key_def_s->port, DOUBLE_PRESS, key_mag->press_lag);
+            return;
         }
-    } else if ((long_time2 != 0) && (long_time1 == 0)) {
-        if (__is_key_press_over_time(key_mag->key_status_s, long_time2)) {
-            type = LONG_PRESS_FOR_TIME2;
-            goto KEY_EVENT;
+        __key_event_push(key_mag->key_def_s->key_cb, key_mag->key_def_s->port, SHORT_PRESS, key_mag->dbl_lag);
+    } else if ((type == SHORT_PRESS) && (key_mag->key_def_s->double_press_time)) {
+        /* hold the short press until the double press window closes, a second press overwrites press_lag */
+        key_mag->dbl_wait = key_mag->key_def_s->double_press_time;
+        key_mag->dbl_lag = key_mag->press_lag;
+        return;
+    } else {
+        ;
+    }
+    __key_event_push(key_mag->key_def_s->key_cb, key_mag->key_def_s->port, type, key_mag->press_lag);
+}
+
+/**
+ * @brief update key status and handle key event
+ * @param[inout] key_mag: key manage information
+ * @param[in] key_stat: real-time status, TRUE - press, FALSE - release
+ * @return none
+ */
+STATIC VOID_T __update_key_status(INOUT KEY_MANAGE_T *key_mag, IN CONST BOOL_T key_stat)
+{
+    if (key_stat) {
+        if (!key_mag->pressed) {
+            key_mag->pressed = TRUE;
+            key_mag->press_time = 0;
+            key_mag->reached = 0;
+            /* lag of the irq, main loop and scan timer start, mostly seen after idle or wakeup,
+               a long lag is kept and lands in the top histogram bucket */
+            key_mag->press_lag = 0;
+            if (key_mag->edge_valid) {
+                key_mag->press_lag = tuya_get_clock_time() - key_mag->edge_tm;
+                key_mag->edge_valid = FALSE;
+            }
+        } else {
+            key_mag->press_time += KEY_SCAN_CYCLE_MS;
         }
-        if (__is_key_release_to_release_over_time_and_less_time(key_mag->key_status_s, KEY_PRESS_SHORT_TIME, long_time2)){
-            type = SHORT_PRESS;
-            goto KEY_EVENT;
+        /* only the next threshold is compared on each scan */
+        if ((key_mag->reached < key_mag->thld_num) &&
+            (key_mag->press_time >= key_mag->thld[key_mag->reached].time)) {
+            key_mag->reached++;
+            if ((key_mag->reached == key_mag->thld_num) && (key_mag->hold_fire) && (!key_mag->suppressed)) {
+                __key_emit(key_mag, key_mag->thld[key_mag->reached-1].type);
+            }
         }
-    } else if ((long_time2 == 0) && (long_time1 != 0)) {
-        if (__is_key_press_over_time(key_mag->key_status_s, long_time1)) {
-            type = LONG_PRESS_FOR_TIME1;
-            goto KEY_EVENT;
+    } else if (key_mag->pressed) {
+        key_mag->pressed = FALSE;
+        if (key_mag->suppressed) {
+            key_mag->suppressed = FALSE;
+        } else if ((key_mag->reached > 0) &&
+                   ((key_mag->reached < key_mag->thld_num) || (!key_mag->hold_fire))) {
+            __key_emit(key_mag, key_mag->thld[key_mag->reached-1].type);
+        } else {
+            ;
         }
-        if (__is_key_release_to_release_over_time_and_less_time(key_mag->key_status_s, KEY_PRESS_SHORT_TIME, long_time1)){
-            type = SHORT_PRESS;
-            goto KEY_EVENT;
+    } else if (key_mag->dbl_wait) {
+        /* double press window timeout, the held short press is emitted */
+        if (key_mag->dbl_wait > KEY_SCAN_CYCLE_MS) {
+            key_mag->dbl_wait -= KEY_SCAN_CYCLE_MS;
+        } else {
+            key_mag->dbl_wait = 0;
+            __key_event_push(key_mag->key_def_s->key_cb, key_mag->key_def_s->port, SHORT_PRESS, key_mag->dbl_lag);
         }
     } else {
-        if (__is_key_press_over_time(key_mag->key_status_s, KEY_PRESS_SHORT_TIME)) {
-            type = SHORT_PRESS;
-            goto KEY_EVENT;
-        }
+        ;
     }
-    return;
-    /* handle key event */
-KEY_EVENT:
-    /* if the time parameter has been exchanged before the judgment */
-    if (time_exchange) {
-        /* exchanged the event type  */
-        if (type == LONG_PRESS_FOR_TIME2) {
-            type = LONG_PRESS_FOR_TIME1;
-        } else if (type == LONG_PRESS_FOR_TIME1) {
-            type = LONG_PRESS_FOR_TIME2;
-        } else {
-            ;
-        }
+}
+
+/**
+ * @brief update key chord status and handle chord event
+ * @param[inout] chord_mag: key chord manage information
+ * @return none
+ */
+STATIC VOID_T __update_key_chord_status(INOUT KEY_CHORD_MANAGE_T *chord_mag)
+{
+    KEY_MANAGE_T *key_mag1 = chord_mag->key_mag[0];
+    KEY_MANAGE_T *key_mag2 = chord_mag->key_mag[1];
+
+    if ((!key_mag1->pressed) || (!key_mag2->pressed)) {
+        chord_mag->fired = FALSE;
+        return;
+    }
+    if (chord_mag->fired) {
+        return;
+    }
+    /* the key pressed last decides the common hold time */
+    if ((key_mag1->press_time >= chord_mag->chord_def_s->hold_time) &&
+        (key_mag2->press_time >= chord_mag->chord_def_s->hold_time)) {
+        chord_mag->fired = TRUE;
+        key_mag1->suppressed = TRUE;
+        key_mag1->dbl_wait = 0;
+        key_mag2->suppressed = TRUE;
+        key_mag2->dbl_wait = 0;
+        __key_event_push(chord_mag->chord_def_s->key_cb, chord_mag->chord_def_s->port1, CHORD_PRESS,
+                         (key_mag1->press_lag > key_mag2->press_lag) ? key_mag1->press_lag : key_mag2->press_lag);
     }
-    /* execute the callback function */
-    key_mag->key_def_s->key_cb(type);
+}
+
+/**
+ * @brief is key idle, released and no event is pending
+ * @param[in] key_mag: key manage information
+ * @return TRUE or FALSE
+ */
+STATIC BOOL_T __is_key_idle(IN CONST KEY_MANAGE_T *key_mag)
+{
+    if ((!key_mag->pressed) &&
+        (key_mag->dbl_wait == 0)) {
+        return TRUE;
+    }
+    return FALSE;
 }
 
 /**
  * @brief key timeout handler
  * @param[in] none
- * @return none
+ * @return 0 - keep scanning, KEY_SCAN_STOP - all keys idle, timer removed
  */
 STATIC INT_T __key_timeout_handler(VOID_T)
 {
+    BOOL_T idle = TRUE;
+    UCHAR_T level[TY_GPIO_GROUP_NUM];
     KEY_MANAGE_T *key_mag_tmp = sg_key_mag_list;
-    if (NULL == key_mag_tmp) {
-        return 0;
-    }
+    KEY_CHORD_MANAGE_T *chord_mag_tmp = sg_key_chord_list;
+    /* each group input register is read once per scan whatever the number of keys */
+    __sample_key_groups(level);
     while (key_mag_tmp) {
-        __update_key_status(key_mag_tmp);
-        __detect_and_handle_key_event(key_mag_tmp);
+        __update_key_status(key_mag_tmp, __get_key_stat(key_mag_tmp, level));
+        if (!__is_key_idle(key_mag_tmp)) {
+            idle = FALSE;
+        }
         key_mag_tmp = key_mag_tmp->next;
     }
+    while (chord_mag_tmp) {
+        __update_key_chord_status(chord_mag_tmp);
+        chord_mag_tmp = chord_mag_tmp->next;
+    }
+    if (idle) {
+        /* a press edge from now on sets the flag again and restarts scanning in main loop */
+        sg_key_scan_active = FALSE;
+        return KEY_SCAN_STOP;
+    }
     return 0;
 }
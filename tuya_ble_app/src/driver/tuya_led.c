@@ -12,11 +12,17 @@
 #include "tuya_led.h"
 #include "tuya_ble_mem.h"
 #include "tuya_timer.h"
+#include "tuya_pwm.h"
 
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
-#define LED_TIMER_VAL_MS    100
+#define LED_TICK_PER_MS     (TY_CLOCK_TICK_PER_US * 1000)
+#define LED_TIMER_STOP      (-1)    /* return value that removes the software timer */
+#define LED_DEADLINE_NONE   0xFFFFFFFF
+#define LED_PWM_FREQ_HZ     1000
+#define LED_PAT_LOOP_DEPTH  2       /* nested repeats of a pattern */
+#define LED_PAT_OPS_MAX     16      /* untimed steps run at once, guards against a loop without duration */
 
 /***********************************************************
 ***********************typedef define***********************
@@ -24,6 +30,7 @@
 typedef struct {
     TY_GPIO_PORT_E pin;             /* led pin */
     BOOL_T active_low;              /* led light on is active low? */
+    BOOL_T pwm;                     /* driven by pwm, otherwise any level above 0 is full on */
 } LED_DRV_T;
 
 typedef struct {
@@ -31,38 +38,132 @@ typedef struct {
     LED_FLASH_TYPE_E type;          /* flash type */
     USHORT_T on_time;               /* light on time */
     USHORT_T off_time;              /* light off time */
-    UINT_T total;                   /* flash total time or total count */
+    UINT_T total;                   /* remaining flash time (ms) or remaining count */
     LED_CALLBACK end_cb;            /* flash end callback function */
-    UINT_T work_timer;              /* flash work timer */
+    BOOL_T light;                   /* current light status */
+    UINT_T phase_remain;            /* time to the next toggle or pattern step (ms) */
+    CONST LED_PAT_STEP_T *pat;      /* running pattern, NULL for on/off flash */
+    UCHAR_T pc;                     /* next pattern step */
+    UCHAR_T level;                  /* current level of flash or pattern */
+    UCHAR_T loop_depth;             /* active repeats */
+    UCHAR_T loop_pc[LED_PAT_LOOP_DEPTH];        /* step of each active repeat */
+    USHORT_T loop_remain[LED_PAT_LOOP_DEPTH];   /* jumps left of each active repeat */
 } LED_FLASH_T;
 
 typedef struct led_manage_s {
     struct led_manage_s *next;
     LED_DRV_T drv_s;
-    LED_FLASH_T *flash;             /* led flash related */
-    BOOL_T stop_flash_req;          /* stop flashing request */
-    BOOL_T stop_flash_light;        /* light status after stopping flashing */
+    LED_FLASH_T flash_s;            /* flash descriptor, no allocation when flashing starts */
+    LED_FLASH_T *flash;             /* led flash related, points to flash_s while flashing */
+    struct led_group_s *group;      /* group the led belongs to, NULL if none */
 } LED_MANAGE_T;
 
+typedef struct led_group_s {
+    struct led_group_s *next;
+    LED_MANAGE_T *member[LED_GROUP_MEMBER_MAX];
+    UCHAR_T num;                                /* number of members */
+    UCHAR_T port_mask[TY_GPIO_GROUP_NUM];       /* member pins of each gpio group */
+    UCHAR_T port_low[TY_GPIO_GROUP_NUM];        /* active low member pins of each gpio group */
+    LED_FLASH_T flash_s;            /* pattern descriptor, the level of a step is the mask of lit members */
+    LED_FLASH_T *flash;             /* points to flash_s while a pattern runs */
+} LED_GROUP_T;
+
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
 STATIC LED_MANAGE_T *sg_led_mag_list = NULL;
+STATIC LED_GROUP_T *sg_led_group_list = NULL;
+STATIC BOOL_T sg_led_timer_active = FALSE;      /* flash timer is armed */
+STATIC BOOL_T sg_led_in_handler = FALSE;        /* flash timer handler is running */
+STATIC UINT_T sg_led_last_tm = 0;               /* clock time all flashes were advanced to */
 
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
 STATIC INT_T __led_timeout_handler(VOID_T);
+STATIC VOID_T __set_led_level(IN CONST LED_DRV_T drv_s, IN CONST UCHAR_T level);
+STATIC VOID_T __set_led_group_light(IN CONST LED_GROUP_T *group, IN CONST UCHAR_T mask);
+STATIC VOID_T __led_flash_advance_all(VOID_T);
+
+/**
+ * @brief led gpio init, pwm is used when the pin supports it
+ * @param[inout] drv_s: pin and active level
+ * @return none
+ */
+STATIC VOID_T __led_gpio_init(INOUT LED_DRV_T *drv_s)
+{
+    tuya_gpio_init(drv_s->pin, FALSE, drv_s->active_low);
+    drv_s->pwm = (PWM_OK == tuya_pwm_init(drv_s->pin, LED_PWM_FREQ_HZ, drv_s->active_low)) ? TRUE : FALSE;
+}
+
+/**
+ * @brief get the time to the next deadline of a flashing led
+ * @param[in] flash: led flash
+ * @return time to the next toggle or flash end (ms)
+ */
+STATIC UINT_T __led_flash_deadline(IN CONST LED_FLASH_T *flash)
+{
+    if ((flash->pat == NULL) && (flash->mode == LFM_SPEC_TIME) && (flash->total < flash->phase_remain)) {
+        return flash->total;
+    }
+    return flash->phase_remain;
+}
+
+/**
+ * @brief get the earliest deadline of all flashing leds
+ * @param[in] none
+ * @return time to the earliest deadline (ms), LED_DEADLINE_NONE if nothing is flashing
+ */
+STATIC UINT_T __led_next_deadline(VOID_T)
+{
+    UINT_T next = LED_DEADLINE_NONE, deadline;
+    LED_MANAGE_T *led_mag_tmp = sg_led_mag_list;
+    LED_GROUP_T *group_tmp = sg_led_group_list;
+    while (led_mag_tmp) {
+        if (led_mag_tmp->flash != NULL) {
+            deadline = __led_flash_deadline(led_mag_tmp->flash);
+            if (deadline < next) {
+                next = deadline;
+            }
+        }
+        led_mag_tmp = led_mag_tmp->next;
+    }
+    while (group_tmp) {
+        if ((group_tmp->flash != NULL) && (group_tmp->flash->phase_remain < next)) {
+            next = group_tmp->flash->phase_remain;
+        }
+        group_tmp = group_tmp->next;
+    }
+    return next;
+}
 
 /**
- * @brief led gpio init
- * @param[in] pin: pin number
- * @param[in] active_low: TRUE - active low, FALSE - active high
+ * @brief arm the flash timer for the earliest deadline, or stop it if nothing is flashing
+ * @param[in] none
  * @return none
  */
-STATIC VOID_T __led_gpio_init(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T active_low)
+STATIC VOID_T __led_timer_rearm(VOID_T)
 {
-    tuya_gpio_init(port, FALSE, active_low);
+    UINT_T next;
+
+    /* the handler re-arms itself by its return value */
+    if (sg_led_in_handler) {
+        return;
+    }
+    if (sg_led_timer_active) {
+        tuya_software_timer_delete(__led_timeout_handler);
+        sg_led_timer_active = FALSE;
+    }
+    next = __led_next_deadline();
+    if (next == LED_DEADLINE_NONE) {
+        return;
+    }
+    if (next == 0) {
+        next = 1;
+    }
+    if (TIMER_OK == tuya_software_timer_create(next*1000, __led_timeout_handler)) {
+        sg_led_timer_active = TRUE;
+    }
 }
 
 /**
@@ -84,6 +185,7 @@ LED_RET tuya_create_led_handle(IN CONST TY_GPIO_PORT_E pin, IN CONST UCHAR_T act
     if (NULL == led_mag) {
         return LED_ERR_MALLOC_FAILED;
     }
+    memset(led_mag, 0, SIZEOF(LED_MANAGE_T));
 
     /* update led manage list */
     led_mag->drv_s.pin = pin;
@@ -92,13 +194,11 @@ LED_RET tuya_create_led_handle(IN CONST TY_GPIO_PORT_E pin, IN CONST UCHAR_T act
 
     if (sg_led_mag_list) {
         led_mag->next = sg_led_mag_list;
-    } else {
-        tuya_software_timer_create(LED_TIMER_VAL_MS*1000, __led_timeout_handler);
     }
     sg_led_mag_list = led_mag;
 
     /* gpio init */
-    __led_gpio_init(pin, active_low);
+    __led_gpio_init(&led_mag->drv_s);
 
     return LED_OK;
 }
@@ -111,18 +211,46 @@ LED_RET tuya_create_led_handle(IN CONST TY_GPIO_PORT_E pin, IN CONST UCHAR_T act
 LED_RET tuya_led_reset(VOID_T)
 {
     LED_MANAGE_T *led_mag_tmp = sg_led_mag_list;
+    LED_GROUP_T *group_tmp = sg_led_group_list;
     if (NULL == led_mag_tmp) {
         return LED_ERR_INVALID_PARM;
     }
     while (led_mag_tmp) {
-        __led_gpio_init(led_mag_tmp->drv_s.pin, led_mag_tmp->drv_s.active_low);
+        __led_gpio_init(&led_mag_tmp->drv_s);
+        if (led_mag_tmp->flash != NULL) {
+            __set_led_level(led_mag_tmp->drv_s, led_mag_tmp->flash->level);
+        }
         led_mag_tmp = led_mag_tmp->next;
     }
-    tuya_software_timer_delete(__led_timeout_handler);
-    tuya_software_timer_create(LED_TIMER_VAL_MS*1000, __led_timeout_handler);
+    while (group_tmp) {
+        if (group_tmp->flash != NULL) {
+            __set_led_group_light(group_tmp, group_tmp->flash->level);
+        }
+        group_tmp = group_tmp->next;
+    }
+    /* flashes continue from where they were, the sleep time is not counted */
+    sg_led_last_tm = tuya_get_clock_time();
+    __led_timer_rearm();
     return LED_OK;
 }
 
+/**
+ * @brief set led level
+ * @param[in] drv_s: pin and active level
+ * @param[in] level: 0 - light off, LED_LEVEL_MAX - full on
+ * @return none
+ */
+STATIC VOID_T __set_led_level(IN CONST LED_DRV_T drv_s, IN CONST UCHAR_T level)
+{
+    if (drv_s.pwm) {
+        tuya_pwm_set_duty(drv_s.pin, level);
+    } else if (drv_s.active_low) {
+        tuya_gpio_write(drv_s.pin, (level == 0));
+    } else {
+        tuya_gpio_write(drv_s.pin, (level != 0));
+    }
+}
+
 /**
  * @brief set led light on or off
  * @param[in] drv_s: pin and active level
@@ -131,10 +259,20 @@ LED_RET tuya_led_reset(VOID_T)
  */
 STATIC VOID_T __set_led_light(IN CONST LED_DRV_T drv_s, IN CONST BOOL_T on_off)
 {
-    if (drv_s.active_low) {
-        tuya_gpio_write(drv_s.pin, !on_off);
-    } else {
-        tuya_gpio_write(drv_s.pin, on_off);
+    __set_led_level(drv_s, (on_off) ? LED_LEVEL_MAX : 0);
+}
+
+/**
+ * @brief stop the flash of a led and the pattern of its group, the led is driven alone after this
+ * @param[inout] led_mag: led management
+ * @return none
+ */
+STATIC VOID_T __led_release(INOUT LED_MANAGE_T *led_mag)
+{
+    /* the flash timer stops by itself when nothing is flashing */
+    led_mag->flash = NULL;
+    if (led_mag->group != NULL) {
+        led_mag->group->flash = NULL;
     }
 }
 
@@ -147,12 +285,22 @@ STATIC VOID_T __set_led_light(IN CONST LED_DRV_T drv_s, IN CONST BOOL_T on_off)
 LED_RET tuya_set_led_light(IN CONST LED_HANDLE handle, IN CONST BOOL_T on_off)
 {
     LED_MANAGE_T *led_mag = (LED_MANAGE_T *)handle;
-    if (led_mag->flash != NULL) {
-        led_mag->stop_flash_req = TRUE;
-        led_mag->stop_flash_light = on_off;
-    } else {
-        __set_led_light(led_mag->drv_s, on_off);
-    }
+    __led_release(led_mag);
+    __set_led_light(led_mag->drv_s, on_off);
+    return LED_OK;
+}
+
+/**
+ * @brief set led brightness level
+ * @param[in] handle: led handle
+ * @param[in] level: 0 - light off, LED_LEVEL_MAX - full on, levels between need a pwm pin
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_level(IN CONST LED_HANDLE handle, IN CONST UCHAR_T level)
+{
+    LED_MANAGE_T *led_mag = (LED_MANAGE_T *)handle;
+    __led_release(led_mag);
+    __set_led_level(led_mag->drv_s, level);
     return LED_OK;
 }
 
@@ -216,106 +364,455 @@ STATIC BOOL_T __get_led_flash_end_light(IN CONST LED_FLASH_TYPE_E type)
 LED_RET tuya_set_led_flash(IN CONST LED_HANDLE handle, IN CONST LED_FLASH_MODE_E mode, IN CONST LED_FLASH_TYPE_E type, IN CONST USHORT_T on_time, IN CONST USHORT_T off_time, IN CONST UINT_T total, IN CONST LED_CALLBACK flash_end_cb)
 {
     LED_MANAGE_T *led_mag = (LED_MANAGE_T *)handle;
-    led_mag->stop_flash_req = FALSE;
-    if (led_mag->flash == NULL) {
-        LED_FLASH_T *led_flash = (LED_FLASH_T *)tuya_ble_malloc(SIZEOF(LED_FLASH_T));
-        if (NULL == led_flash) {
-            return LED_ERR_MALLOC_FAILED;
-        }
-        led_mag->flash = led_flash;
+    BOOL_T start_light = __get_led_flash_sta_light(type);
+
+    if ((on_time == 0) && (off_time == 0)) {
+        return LED_ERR_INVALID_PARM;
     }
+    /* bring the other flashes up to now before the timer is re-armed */
+    __led_flash_advance_all();
+
+    __led_release(led_mag);
+    led_mag->flash = &led_mag->flash_s;
+    led_mag->flash->pat = NULL;
     led_mag->flash->mode = mode;
     led_mag->flash->type = type;
     led_mag->flash->on_time = on_time;
     led_mag->flash->off_time = off_time;
     led_mag->flash->total = total;
-    led_mag->flash->work_timer = 0;
     led_mag->flash->end_cb = flash_end_cb;
-    __set_led_light(led_mag->drv_s, __get_led_flash_sta_light(type));
+    led_mag->flash->light = start_light;
+    led_mag->flash->level = (start_light) ? LED_LEVEL_MAX : 0;
+    led_mag->flash->phase_remain = (start_light) ? on_time : off_time;
+    __set_led_light(led_mag->drv_s, start_light);
+
+    __led_timer_rearm();
     return LED_OK;
 }
 
 /**
- * @brief led flash process
+ * @brief end the flash or pattern of a led
  * @param[inout] led_mag: led management
+ * @param[in] end_level: level after the end
  * @return none
  */
-STATIC VOID_T __led_flash_proc(INOUT LED_MANAGE_T *led_mag)
+STATIC VOID_T __led_flash_end(INOUT LED_MANAGE_T *led_mag, IN CONST UCHAR_T end_level)
 {
-    BOOL_T one_cycle_flag = FALSE;
-    UINT_T sum_time;
-    BOOL_T start_light;
-    USHORT_T start_time;
-
-    /* get flash settings */
-    sum_time = led_mag->flash->on_time + led_mag->flash->off_time;
-    start_light = __get_led_flash_sta_light(led_mag->flash->type);
-    start_time = (start_light) ? led_mag->flash->on_time : led_mag->flash->off_time;
-
-    /* flash cycle process */
-    led_mag->flash->work_timer += LED_TIMER_VAL_MS;
-    if (led_mag->flash->work_timer >= sum_time) {
-        led_mag->flash->work_timer -= sum_time;
-        __set_led_light(led_mag->drv_s, start_light);
-        one_cycle_flag = TRUE;
-    } else if (led_mag->flash->work_timer >= start_time) {
-        __set_led_light(led_mag->drv_s, !start_light);
-    } else {
-        ;
+    LED_CALLBACK end_cb = led_mag->flash->end_cb;
+
+    __set_led_level(led_mag->drv_s, end_level);
+    led_mag->flash = NULL;
+    /* called last, so that the callback can start a new flash on this led */
+    if (end_cb != NULL) {
+        end_cb();
     }
+}
+
+/**
+ * @brief led flash process, advance the flash by the elapsed time
+ * @param[inout] led_mag: led management
+ * @param[in] elapsed: elapsed time (ms)
+ * @return none
+ */
+STATIC VOID_T __led_flash_proc(INOUT LED_MANAGE_T *led_mag, IN UINT_T elapsed)
+{
+    LED_FLASH_T *flash = led_mag->flash;
+    BOOL_T start_light = __get_led_flash_sta_light(flash->type);
+    BOOL_T light = flash->light;
 
     /* flash countdown process */
-    if (led_mag->flash->mode == LFM_FOREVER) {
-        return;
+    if (flash->mode == LFM_SPEC_TIME) {
+        if (flash->total <= elapsed) {
+            __led_flash_end(led_mag, (__get_led_flash_end_light(flash->type)) ? LED_LEVEL_MAX : 0);
+            return;
+        }
+        flash->total -= elapsed;
     }
-    if (led_mag->flash->mode == LFM_SPEC_TIME) {
-        if (led_mag->flash->total > LED_TIMER_VAL_MS) {
-            led_mag->flash->total -= LED_TIMER_VAL_MS;
+
+    /* flash cycle process, a phase of zero length is skipped */
+    while (elapsed >= flash->phase_remain) {
+        elapsed -= flash->phase_remain;
+        if (flash->light == start_light) {
+            flash->light = !start_light;
+            flash->phase_remain = (start_light) ? flash->off_time : flash->on_time;
         } else {
-            led_mag->flash->total = 0;
+            flash->light = start_light;
+            flash->phase_remain = (start_light) ? flash->on_time : flash->off_time;
+            if (flash->mode == LFM_SPEC_COUNT) {
+                if (flash->total > 0) {
+                    flash->total--;
+                }
+                if (flash->total == 0) {
+                    __led_flash_end(led_mag, (__get_led_flash_end_light(flash->type)) ? LED_LEVEL_MAX : 0);
+                    return;
+                }
+            }
         }
-    } else if (led_mag->flash->mode == LFM_SPEC_COUNT) {
-        if (one_cycle_flag) {
-            if (led_mag->flash->total > 0) {
-                led_mag->flash->total--;
+    }
+    flash->phase_remain -= elapsed;
+
+    if (flash->light != light) {
+        flash->level = (flash->light) ? LED_LEVEL_MAX : 0;
+        __set_led_light(led_mag->drv_s, flash->light);
+    }
+}
+
+/**
+ * @brief run pattern steps until a step with duration
+ * @param[inout] flash: pattern of a led or a led group
+ * @return TRUE - a timed step is running, FALSE - the pattern ended, level is the end level
+ */
+STATIC BOOL_T __led_pat_step(INOUT LED_FLASH_T *flash)
+{
+    CONST LED_PAT_STEP_T *step;
+    UCHAR_T ops;
+
+    for (ops = 0; ops < LED_PAT_OPS_MAX; ops++) {
+        step = &flash->pat[flash->pc];
+        switch (step->op) {
+        case LED_PAT_OP_LEVEL:
+            flash->level = step->arg;
+            flash->phase_remain = step->val;
+            flash->pc++;
+            if (step->val != 0) {
+                return TRUE;
             }
+            break;
+        case LED_PAT_OP_REPEAT:
+            /* the innermost active repeat belongs to this step, or a new one starts */
+            if ((flash->loop_depth > 0) && (flash->loop_pc[flash->loop_depth-1] == flash->pc)) {
+                if (--flash->loop_remain[flash->loop_depth-1] == 0) {
+                    flash->loop_depth--;
+                    flash->pc++;
+                    break;
+                }
+            } else if (step->val != 0) {
+                if ((step->val == 1) || (flash->loop_depth >= LED_PAT_LOOP_DEPTH)) {
+                    flash->pc++;
+                    break;
+                }
+                flash->loop_pc[flash->loop_depth] = flash->pc;
+                flash->loop_remain[flash->loop_depth] = step->val - 1;
+                flash->loop_depth++;
+            } else {
+                ;
+            }
+            flash->pc = step->arg;
+            break;
+        case LED_PAT_OP_END:
+        default:
+            flash->level = step->arg;
+            return FALSE;
+        }
+    }
+    /* no step with duration found, the pattern is broken */
+    flash->level = 0;
+    return FALSE;
+}
+
+/**
+ * @brief advance a pattern by the elapsed time
+ * @param[inout] flash: pattern of a led or a led group
+ * @param[in] elapsed: elapsed time (ms)
+ * @return TRUE - the pattern is running, FALSE - the pattern ended, level is the end level
+ */
+STATIC BOOL_T __led_pat_advance(INOUT LED_FLASH_T *flash, IN UINT_T elapsed)
+{
+    while (elapsed >= flash->phase_remain) {
+        elapsed -= flash->phase_remain;
+        if (!__led_pat_step(flash)) {
+            return FALSE;
         }
+    }
+    flash->phase_remain -= elapsed;
+    return TRUE;
+}
+
+/**
+ * @brief led pattern process, advance the pattern by the elapsed time
+ * @param[inout] led_mag: led management
+ * @param[in] elapsed: elapsed time (ms)
+ * @return none
+ */
+STATIC VOID_T __led_pat_proc(INOUT LED_MANAGE_T *led_mag, IN UINT_T elapsed)
+{
+    LED_FLASH_T *flash = led_mag->flash;
+    UCHAR_T level = flash->level;
+
+    if (!__led_pat_advance(flash, elapsed)) {
+        __led_flash_end(led_mag, flash->level);
+        return;
+    }
+    if (flash->level != level) {
+        __set_led_level(led_mag->drv_s, flash->level);
+    }
+}
+
+/**
+ * @brief set led pattern
+ * @param[in] handle: led handle
+ * @param[in] pat: pattern steps, must stay valid while running, normally a const table
+ * @param[in] pat_end_cb: pattern end callback function
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_pattern(IN CONST LED_HANDLE handle, IN CONST LED_PAT_STEP_T *pat, IN CONST LED_CALLBACK pat_end_cb)
+{
+    LED_MANAGE_T *led_mag = (LED_MANAGE_T *)handle;
+    LED_FLASH_T *flash;
+
+    if (NULL == pat) {
+        return LED_ERR_INVALID_PARM;
+    }
+    /* bring the other flashes up to now before the timer is re-armed */
+    __led_flash_advance_all();
+
+    __led_release(led_mag);
+    flash = &led_mag->flash_s;
+    flash->pat = pat;
+    flash->pc = 0;
+    flash->loop_depth = 0;
+    flash->end_cb = pat_end_cb;
+    flash->level = 0;
+    led_mag->flash = flash;
+    if (__led_pat_step(flash)) {
+        __set_led_level(led_mag->drv_s, flash->level);
     } else {
-        ;
+        __led_flash_end(led_mag, flash->level);
+    }
+
+    __led_timer_rearm();
+    return LED_OK;
+}
+
+/**
+ * @brief tuya create led group, the members are then driven together with one port write per gpio group
+ * @param[in] leds: member led handles, bit n of a group mask is leds[n]
+ * @param[in] num: number of members, 1 ~ LED_GROUP_MEMBER_MAX
+ * @param[out] handle: led group handle
+ * @return LED_RET
+ */
+LED_RET tuya_create_led_group(IN CONST LED_HANDLE *leds, IN CONST UCHAR_T num, OUT LED_GROUP_HANDLE *handle)
+{
+    LED_GROUP_T *group;
+    LED_MANAGE_T *member;
+    UCHAR_T i;
+
+    if ((NULL == leds) || (NULL == handle) || (num == 0) || (num > LED_GROUP_MEMBER_MAX)) {
+        return LED_ERR_INVALID_PARM;
+    }
+    /* a led belongs to one group at most */
+    for (i = 0; i < num; i++) {
+        if ((NULL == leds[i]) || (((LED_MANAGE_T *)leds[i])->group != NULL)) {
+            return LED_ERR_INVALID_PARM;
+        }
     }
 
-    /* flash end process */
-    if (led_mag->flash->total == 0) {
-        if (led_mag->flash->end_cb != NULL) {
-            led_mag->flash->end_cb();
+    group = (LED_GROUP_T *)tuya_ble_malloc(SIZEOF(LED_GROUP_T));
+    if (NULL == group) {
+        return LED_ERR_MALLOC_FAILED;
+    }
+    memset(group, 0, SIZEOF(LED_GROUP_T));
+
+    /* the port masks are computed once here, each group update only writes them */
+    for (i = 0; i < num; i++) {
+        member = (LED_MANAGE_T *)leds[i];
+        member->group = group;
+        group->member[i] = member;
+        group->port_mask[TY_GPIO_GROUP(member->drv_s.pin)] |= TY_GPIO_BIT(member->drv_s.pin);
+        if (member->drv_s.active_low) {
+            group->port_low[TY_GPIO_GROUP(member->drv_s.pin)] |= TY_GPIO_BIT(member->drv_s.pin);
+        }
+    }
+    group->num = num;
+    *handle = (LED_GROUP_HANDLE)group;
+
+    group->next = sg_led_group_list;
+    sg_led_group_list = group;
+    return LED_OK;
+}
+
+/**
+ * @brief set the lit members of a led group
+ * @param[in] group: led group
+ * @param[in] mask: lit members, bit n is member n
+ * @return none
+ */
+STATIC VOID_T __set_led_group_light(IN CONST LED_GROUP_T *group, IN CONST UCHAR_T mask)
+{
+    UCHAR_T level[TY_GPIO_GROUP_NUM] = {0};
+    UCHAR_T i;
+
+    for (i = 0; i < group->num; i++) {
+        if (mask & (1 << i)) {
+            level[TY_GPIO_GROUP(group->member[i]->drv_s.pin)] |= TY_GPIO_BIT(group->member[i]->drv_s.pin);
         }
-        led_mag->stop_flash_req = TRUE;
-        led_mag->stop_flash_light = __get_led_flash_end_light(led_mag->flash->type);
     }
+    for (i = 0; i < TY_GPIO_GROUP_NUM; i++) {
+        if (group->port_mask[i] != 0) {
+            tuya_gpio_write_port(i, group->port_mask[i], level[i] ^ group->port_low[i]);
+        }
+    }
+}
+
+/**
+ * @brief take the members over from single led control
+ * @param[inout] group: led group
+ * @return none
+ */
+STATIC VOID_T __led_group_take(INOUT LED_GROUP_T *group)
+{
+    UCHAR_T i;
+
+    for (i = 0; i < group->num; i++) {
+        group->member[i]->flash = NULL;
+        /* stop the pwm, the pin is then driven as gpio by the port writes */
+        if (group->member[i]->drv_s.pwm) {
+            __set_led_level(group->member[i]->drv_s, 0);
+        }
+    }
+}
+
+/**
+ * @brief end the pattern of a led group
+ * @param[inout] group: led group
+ * @param[in] end_mask: lit members after the end
+ * @return none
+ */
+STATIC VOID_T __led_group_end(INOUT LED_GROUP_T *group, IN CONST UCHAR_T end_mask)
+{
+    LED_CALLBACK end_cb = group->flash->end_cb;
+
+    __set_led_group_light(group, end_mask);
+    group->flash = NULL;
+    /* called last, so that the callback can start a new pattern on this group */
+    if (end_cb != NULL) {
+        end_cb();
+    }
+}
+
+/**
+ * @brief led group pattern process, advance the pattern by the elapsed time
+ * @param[inout] group: led group
+ * @param[in] elapsed: elapsed time (ms)
+ * @return none
+ */
+STATIC VOID_T __led_group_pat_proc(INOUT LED_GROUP_T *group, IN UINT_T elapsed)
+{
+    LED_FLASH_T *flash = group->flash;
+    UCHAR_T mask = flash->level;
+
+    if (!__led_pat_advance(flash, elapsed)) {
+        __led_group_end(group, flash->level);
+        return;
+    }
+    if (flash->level != mask) {
+        __set_led_group_light(group, flash->level);
+    }
+}
+
+/**
+ * @brief set the lit members of a led group
+ * @param[in] handle: led group handle
+ * @param[in] mask: lit members, bit n is member n
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_group_light(IN CONST LED_GROUP_HANDLE handle, IN CONST UCHAR_T mask)
+{
+    LED_GROUP_T *group = (LED_GROUP_T *)handle;
+
+    __led_group_take(group);
+    group->flash = NULL;
+    __set_led_group_light(group, mask);
+    return LED_OK;
+}
+
+/**
+ * @brief set led group pattern, all members follow one phase
+ * @param[in] handle: led group handle
+ * @param[in] pat: pattern steps, the level of a step is the mask of lit members, see LED_PAT_MASK
+ * @param[in] pat_end_cb: pattern end callback function
+ * @return LED_RET
+ */
+LED_RET tuya_set_led_group_pattern(IN CONST LED_GROUP_HANDLE handle, IN CONST LED_PAT_STEP_T *pat, IN CONST LED_CALLBACK pat_end_cb)
+{
+    LED_GROUP_T *group = (LED_GROUP_T *)handle;
+    LED_FLASH_T *flash;
+
+    if (NULL == pat) {
+        return LED_ERR_INVALID_PARM;
+    }
+    /* bring the other flashes up to now before the timer is re-armed */
+    __led_flash_advance_all();
+
+    __led_group_take(group);
+    flash = &group->flash_s;
+    flash->pat = pat;
+    flash->pc = 0;
+    flash->loop_depth = 0;
+    flash->end_cb = pat_end_cb;
+    flash->level = 0;
+    group->flash = flash;
+    if (__led_pat_step(flash)) {
+        __set_led_group_light(group, flash->level);
+    } else {
+        __led_group_end(group, flash->level);
+    }
+
+    __led_timer_rearm();
+    return LED_OK;
 }
 
 /**
- * @brief led timeout handler
+ * @brief advance all flashing leds to the current time
  * @param[in] none
  * @return none
  */
-STATIC INT_T __led_timeout_handler(VOID_T)
+STATIC VOID_T __led_flash_advance_all(VOID_T)
 {
     LED_MANAGE_T *led_mag_tmp = sg_led_mag_list;
-    if (NULL == led_mag_tmp) {
-        return 0;
-    }
+    LED_GROUP_T *group_tmp = sg_led_group_list;
+    UINT_T elapsed = (tuya_get_clock_time() - sg_led_last_tm) / LED_TICK_PER_MS;
+
+    /* the remainder below 1ms is kept for the next call */
+    sg_led_last_tm += elapsed * LED_TICK_PER_MS;
     while (led_mag_tmp) {
-        if (led_mag_tmp->stop_flash_req) {
-            __set_led_light(led_mag_tmp->drv_s, led_mag_tmp->stop_flash_light);
-            tuya_ble_free((UCHAR_T *)led_mag_tmp->flash);
-            led_mag_tmp->flash = NULL;
-            led_mag_tmp->stop_flash_req = FALSE;
-        }
-        if (NULL != led_mag_tmp->flash) {
-            __led_flash_proc(led_mag_tmp);
+        if (led_mag_tmp->flash == NULL) {
+            ;
+        } else if (led_mag_tmp->flash->pat != NULL) {
+            __led_pat_proc(led_mag_tmp, elapsed);
+        } else {
+            __led_flash_proc(led_mag_tmp, elapsed);
         }
         led_mag_tmp = led_mag_tmp->next;
     }
-    return 0;
+    while (group_tmp) {
+        if (group_tmp->flash != NULL) {
+            __led_group_pat_proc(group_tmp, elapsed);
+        }
+        group_tmp = group_tmp->next;
+    }
+}
+
+/**
+ * @brief led timeout handler, one-shot for the earliest deadline
+ * @param[in] none
+ * @return next interval (us), LED_TIMER_STOP - nothing is flashing, timer removed
+ */
+STATIC INT_T __led_timeout_handler(VOID_T)
+{
+    UINT_T next;
+
+    sg_led_in_handler = TRUE;
+    __led_flash_advance_all();
+    sg_led_in_handler = FALSE;
+
+    next = __led_next_deadline();
+    if (next == LED_DEADLINE_NONE) {
+        sg_led_timer_active = FALSE;
+        return LED_TIMER_STOP;
+    }
+    if (next == 0) {
+        next = 1;
+    }
+    return (INT_T)(next*1000);
 }
@@ -10,7 +10,6 @@
  */
 
 #include "tuya_seg_lcd.h"
-#include "tuya_ble_mem.h"
 #include "tuya_timer.h"
 
 /***********************************************************
@@ -20,6 +19,8 @@
 #define SEG_LCD_DISP_MAX_NUM        999
 #define SEG_LCD_COM_SCAN_CYCLE_MS   3
 #define SEG_LCD_FLASH_PROC_CYCLE_MS 10
+#define SEG_LCD_PHASE_BUF_NUM       2
+#define SEG_LCD_DRIVE_STEP_NUM      2       /* STEP_COM_HIGH and STEP_COM_LOW */
 
 /***********************************************************
 ***********************typedef define***********************
@@ -33,13 +34,26 @@ typedef struct {
     UINT_T work_timer;              /* flash work timer */
 } SEG_LCD_FLASH_T;
 
+/* port registers of one COM phase */
+typedef struct {
+    UCHAR_T drive[TY_GPIO_GROUP_NUM];                           /* pins driven in the phase */
+    UCHAR_T level[SEG_LCD_DRIVE_STEP_NUM][TY_GPIO_GROUP_NUM];   /* output levels of each driving step */
+} SEG_LCD_PHASE_T;
+
 typedef struct {
     SEG_LCD_PIN_T pin;              /* pin */
     UCHAR_T seg_pin_code[COM_NUM];  /* output level code of SEG pin */
+    SEG_LCD_PHASE_T phase[SEG_LCD_PHASE_BUF_NUM][COM_NUM];     /* double buffered, written by main loop */
+    volatile UCHAR_T scan_buf;      /* buffer used by the scan, switched by irq at the start of a phase */
+    volatile UCHAR_T ready_buf;     /* newest complete buffer */
+    volatile BOOL_T phase_busy;     /* a buffer is being written, the scan does not switch */
+    UCHAR_T pin_mask[TY_GPIO_GROUP_NUM];    /* COM and SEG pins of each gpio group */
+    BOOL_T sleep;                   /* scan stopped and pins parked */
     BOOL_T light;                   /* light status */
     UCHAR_T scan_com_num;           /* scan com number */
     SEG_LCD_STEP_E scan_step;       /* scan step */
-    SEG_LCD_FLASH_T *flash;         /* flash management */
+    SEG_LCD_FLASH_T flash_s;        /* flash descriptor, no allocation when flashing starts */
+    SEG_LCD_FLASH_T *flash;         /* flash management, points to flash_s while flashing */
     BOOL_T stop_flash_req;          /* stop flashing request */
     BOOL_T stop_flash_light;        /* light status after stopping flashing */
 } SEG_LCD_MANAGE_T;
@@ -94,25 +108,97 @@ STATIC VOID_T __seg_lcd_gpio_init(IN CONST TY_GPIO_PORT_E port)
 }
 
 /**
- * @brief set gpio shutdown
- * @param[in] port: gpio number
+ * @brief get the actual output code
+ * @param[in] seg_pin_code: display seg pin code
  * @return none
  */
-STATIC VOID_T __seg_lcd_gpio_shutdown(IN CONST TY_GPIO_PORT_E port)
+STATIC UCHAR_T __get_actual_output_code(UCHAR_T seg_pin_code)
 {
-    tuya_gpio_set_inout(port, TRUE);
+    UCHAR_T code = seg_pin_code;
+
+    if (!sg_seg_lcd_mag.light) {
+        if (sg_seg_lcd_mag.flash == NULL) {
+            code =  0x00;
+        } else {
+            if (sg_seg_lcd_mag.flash->digit == SEG_LCD_FLASH_DIGIT_ALL) {
+                code = 0x00;
+            } else {
+                code &= ~(ch_com_code[sg_seg_lcd_mag.flash->digit]);
+            }
+        }
+    }
+    return code;
 }
 
 /**
- * @brief gpio write
- * @param[in] port: gpio number
- * @param[in] level: output level (TRUE-high, FALSE-low)
+ * @brief update the port registers of all COM phases, called whenever the output code or the light changes
+ * @param[in] none
  * @return none
  */
-STATIC VOID_T __seg_lcd_gpio_write(IN CONST TY_GPIO_PORT_E port, IN CONST UINT_T level)
+STATIC VOID_T __seg_lcd_update_phase(VOID_T)
 {
-    tuya_gpio_set_inout(port, FALSE);
-    tuya_gpio_write(port, level);
+    SEG_LCD_PHASE_T *phase;
+    TY_GPIO_PORT_E port;
+    UCHAR_T buf, com, i, active_pin, actl_code;
+
+    /* the scan does not switch buffers while this one is written, so it keeps the other one */
+    sg_seg_lcd_mag.phase_busy = TRUE;
+    buf = (sg_seg_lcd_mag.scan_buf == 0) ? 1 : 0;
+    for (com = 0; com < COM_NUM; com++) {
+        phase = &sg_seg_lcd_mag.phase[buf][com];
+        memset(phase, 0, SIZEOF(SEG_LCD_PHASE_T));
+        active_pin = (com == 0) ? 0x2a : 0x3f;
+        actl_code = __get_actual_output_code(sg_seg_lcd_mag.seg_pin_code[com]);
+
+        /* COM pin is high in the first step and low in the second one */
+        port = sg_seg_lcd_mag.pin.com[com];
+        phase->drive[TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+        phase->level[STEP_COM_HIGH][TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+        /* SEG pin of a lit segment is opposite to the COM pin, others follow the COM pin */
+        for (i = 0; i < SEG_NUM; i++) {
+            if (active_pin & (1 << i)) {
+                port = sg_seg_lcd_mag.pin.seg[i];
+                phase->drive[TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+                if (actl_code & (1 << i)) {
+                    phase->level[STEP_COM_LOW][TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+                } else {
+                    phase->level[STEP_COM_HIGH][TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+                }
+            }
+        }
+    }
+    sg_seg_lcd_mag.ready_buf = buf;
+    sg_seg_lcd_mag.phase_busy = FALSE;
+}
+
+/**
+ * @brief start the scan and the flash timer
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __seg_lcd_timer_start(VOID_T)
+{
+    tuya_software_timer_delete(__seg_lcd_timeout_handler);
+    tuya_software_timer_create(SEG_LCD_FLASH_PROC_CYCLE_MS*1000, __seg_lcd_timeout_handler);
+    tuya_hardware_timer_delete(TY_TIMER_0);
+    tuya_hardware_timer_create(TY_TIMER_0, SEG_LCD_COM_SCAN_CYCLE_MS*1000, __seg_lcd_output_ctrl, TY_TIMER_REPEAT);
+}
+
+/**
+ * @brief park all COM and SEG pins low, no voltage across the segments and no floating input
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __seg_lcd_park_pins(VOID_T)
+{
+    UCHAR_T i;
+
+    for (i = 0; i < TY_GPIO_GROUP_NUM; i++) {
+        if (sg_seg_lcd_mag.pin_mask[i] != 0) {
+            tuya_gpio_write_port(i, sg_seg_lcd_mag.pin_mask[i], 0);
+            tuya_gpio_set_port_output(i, sg_seg_lcd_mag.pin_mask[i], sg_seg_lcd_mag.pin_mask[i]);
+        }
+    }
 }
 
 /**
@@ -130,14 +216,16 @@ SEG_LCD_RET tuya_seg_lcd_init(SEG_LCD_PIN_T pin_def)
     /* COM pin init */
     for (i = 0; i < COM_NUM; i++) {
         __seg_lcd_gpio_init(pin_def.com[i]);
+        sg_seg_lcd_mag.pin_mask[TY_GPIO_GROUP(pin_def.com[i])] |= TY_GPIO_BIT(pin_def.com[i]);
     }
     /* SEG pin init */
     for (i = 0; i < SEG_NUM; i++) {
         __seg_lcd_gpio_init(pin_def.seg[i]);
+        sg_seg_lcd_mag.pin_mask[TY_GPIO_GROUP(pin_def.seg[i])] |= TY_GPIO_BIT(pin_def.seg[i]);
     }
+    __seg_lcd_update_phase();
     /* timer init */
-    tuya_software_timer_create(SEG_LCD_FLASH_PROC_CYCLE_MS*1000, __seg_lcd_timeout_handler);
-    tuya_hardware_timer_create(TY_TIMER_0, SEG_LCD_COM_SCAN_CYCLE_MS*1000, __seg_lcd_output_ctrl, TY_TIMER_REPEAT);
+    __seg_lcd_timer_start();
 
     return SEG_LCD_OK;
 }
@@ -158,35 +246,63 @@ SEG_LCD_RET tuya_seg_lcd_reset(VOID_T)
     for (i = 0; i < SEG_NUM; i++) {
         __seg_lcd_gpio_init(sg_seg_lcd_mag.pin.seg[i]);
     }
+    /* a display that was asleep stays asleep */
+    if (sg_seg_lcd_mag.sleep) {
+        __seg_lcd_park_pins();
+        return SEG_LCD_OK;
+    }
     /* timer init */
-    tuya_software_timer_delete(__seg_lcd_timeout_handler);
-    tuya_software_timer_create(SEG_LCD_FLASH_PROC_CYCLE_MS*1000, __seg_lcd_timeout_handler);
+    __seg_lcd_timer_start();
+    return SEG_LCD_OK;
+}
+
+/**
+ * @brief segment lcd sleep, stops the scan and the flash timer and parks the pins
+ * @param[in] none
+ * @return SEG_LCD_RET
+ */
+SEG_LCD_RET tuya_seg_lcd_sleep(VOID_T)
+{
+    if (sg_seg_lcd_mag.sleep) {
+        return SEG_LCD_OK;
+    }
+    sg_seg_lcd_mag.sleep = TRUE;
+    /* the scan irq is stopped first, so that it cannot drive the pins after they are parked */
     tuya_hardware_timer_delete(TY_TIMER_0);
-    tuya_hardware_timer_create(TY_TIMER_0, SEG_LCD_COM_SCAN_CYCLE_MS*1000, __seg_lcd_output_ctrl, TY_TIMER_REPEAT);
+    tuya_software_timer_delete(__seg_lcd_timeout_handler);
+    __seg_lcd_park_pins();
+
+    /* a running flash is dropped without its end callback */
+    sg_seg_lcd_mag.flash = NULL;
+    sg_seg_lcd_mag.stop_flash_req = FALSE;
+    sg_seg_lcd_mag.light = FALSE;
+    __seg_lcd_update_phase();
     return SEG_LCD_OK;
 }
 
 /**
- * @brief get the actual output code
- * @param[in] seg_pin_code: display seg pin code
- * @return none
+ * @brief segment lcd wakeup, the scan restarts from the first COM phase within one scan step
+ * @param[in] none
+ * @return SEG_LCD_RET
  */
-STATIC UCHAR_T __get_actual_output_code(UCHAR_T seg_pin_code)
+SEG_LCD_RET tuya_seg_lcd_wakeup(VOID_T)
 {
-    UCHAR_T code = seg_pin_code;
+    UCHAR_T i;
 
-    if (!sg_seg_lcd_mag.light) {
-        if (sg_seg_lcd_mag.flash == NULL) {
-            code =  0x00;
-        } else {
-            if (sg_seg_lcd_mag.flash->digit == SEG_LCD_FLASH_DIGIT_ALL) {
-                code = 0x00;
-            } else {
-                code &= ~(ch_com_code[sg_seg_lcd_mag.flash->digit]);
-            }
+    if (!sg_seg_lcd_mag.sleep) {
+        return SEG_LCD_OK;
+    }
+    sg_seg_lcd_mag.sleep = FALSE;
+    /* start from the state the high impedance step leaves, so the first phase is a normal one */
+    for (i = 0; i < TY_GPIO_GROUP_NUM; i++) {
+        if (sg_seg_lcd_mag.pin_mask[i] != 0) {
+            tuya_gpio_set_port_output(i, sg_seg_lcd_mag.pin_mask[i], 0);
         }
     }
-    return code;
+    sg_seg_lcd_mag.scan_com_num = 0;
+    sg_seg_lcd_mag.scan_step = STEP_COM_HIGH;
+    __seg_lcd_timer_start();
+    return SEG_LCD_OK;
 }
 
 /**
@@ -196,38 +312,30 @@ STATIC UCHAR_T __get_actual_output_code(UCHAR_T seg_pin_code)
  */
 STATIC INT_T __seg_lcd_output_ctrl(VOID_T)
 {
-    UCHAR_T i, active_pin, actl_code;
-    BOOL_T seg_pin_level;
+    CONST SEG_LCD_PHASE_T *phase;
+    UCHAR_T i;
 
-    active_pin = (sg_seg_lcd_mag.scan_com_num == 0) ? 0x2a : 0x3f;
-    actl_code = __get_actual_output_code(sg_seg_lcd_mag.seg_pin_code[sg_seg_lcd_mag.scan_com_num]);
+    /* a new buffer is taken at the start of a phase only, so both driving steps of a phase match */
+    if ((sg_seg_lcd_mag.scan_step == STEP_COM_HIGH) && (!sg_seg_lcd_mag.phase_busy)) {
+        sg_seg_lcd_mag.scan_buf = sg_seg_lcd_mag.ready_buf;
+    }
+    phase = &sg_seg_lcd_mag.phase[sg_seg_lcd_mag.scan_buf][sg_seg_lcd_mag.scan_com_num];
 
     switch (sg_seg_lcd_mag.scan_step) {
     case STEP_COM_HIGH:
-        __seg_lcd_gpio_write(sg_seg_lcd_mag.pin.com[sg_seg_lcd_mag.scan_com_num], TRUE);
-        for (i = 0; i < SEG_NUM; i++) {
-            if (active_pin & (1 << i)) {
-                seg_pin_level = ((actl_code & (1 << i)) > 0) ? FALSE : TRUE;
-                __seg_lcd_gpio_write(sg_seg_lcd_mag.pin.seg[i], seg_pin_level);
-            }
-        }
-        sg_seg_lcd_mag.scan_step = STEP_COM_LOW;
-        break;
     case STEP_COM_LOW:
-        __seg_lcd_gpio_write(sg_seg_lcd_mag.pin.com[sg_seg_lcd_mag.scan_com_num], FALSE);
-        for (i = 0; i < SEG_NUM; i++) {
-            if (active_pin & (1 << i)) {
-                seg_pin_level = ((actl_code & (1 << i)) > 0) ? TRUE : FALSE;
-                __seg_lcd_gpio_write(sg_seg_lcd_mag.pin.seg[i], seg_pin_level);
+        for (i = 0; i < TY_GPIO_GROUP_NUM; i++) {
+            if (phase->drive[i] != 0) {
+                tuya_gpio_write_port(i, phase->drive[i], phase->level[sg_seg_lcd_mag.scan_step][i]);
+                tuya_gpio_set_port_output(i, phase->drive[i], phase->drive[i]);
             }
         }
-        sg_seg_lcd_mag.scan_step = STEP_COM_HI_Z;
+        sg_seg_lcd_mag.scan_step++;
         break;
     case STEP_COM_HI_Z:
-        __seg_lcd_gpio_shutdown(sg_seg_lcd_mag.pin.com[sg_seg_lcd_mag.scan_com_num]);
-        for (i = 0; i < SEG_NUM; i++) {
-            if (active_pin & (1 << i)) {
-                __seg_lcd_gpio_shutdown(sg_seg_lcd_mag.pin.seg[i]);
+        for (i = 0; i < TY_GPIO_GROUP_NUM; i++) {
+            if (phase->drive[i] != 0) {
+                tuya_gpio_set_port_output(i, phase->drive[i], 0);
             }
         }
         sg_seg_lcd_mag.scan_com_num++;
@@ -298,6 +406,7 @@ SEG_LCD_RET tuya_seg_lcd_disp_num(IN CONST USHORT_T num, IN CONST BOOL_T high_ze
             __generate_seg_pin_output_code(0x00, i);
         }
     }
+    __seg_lcd_update_phase();
     return SEG_LCD_OK;
 }
 
@@ -321,6 +430,7 @@ SEG_LCD_RET tuya_seg_lcd_disp_str(IN CONST CHAR_T *str)
         ch_index[i] = strchr(lcd_str_tbl, *(str++)) - lcd_str_tbl;
         __generate_seg_pin_output_code(ch_seg_code[ch_index[i]], (SEG_LCD_DISP_DIGIT-1-i));
     }
+    __seg_lcd_update_phase();
     return SEG_LCD_OK;
 }
 
@@ -337,6 +447,7 @@ SEG_LCD_RET tuya_seg_lcd_disp_ch(IN CONST CHAR_T ch, IN CONST UCHAR_T digit)
     /* find the character's position and generate SEG pin output code */
     ch_index = strchr(lcd_str_tbl, ch) - lcd_str_tbl;
     __generate_seg_pin_output_code(ch_seg_code[ch_index], digit);
+    __seg_lcd_update_phase();
     return SEG_LCD_OK;
 }
 
@@ -363,6 +474,7 @@ SEG_LCD_RET tuya_seg_lcd_disp_custom_ch(IN CONST SEG_LCD_CH_T cus_ch, IN CONST U
     }
     /* generate SEG pin output code */
     __generate_seg_pin_output_code(seg_code, digit);
+    __seg_lcd_update_phase();
     return SEG_LCD_OK;
 }
 
@@ -373,7 +485,10 @@ SEG_LCD_RET tuya_seg_lcd_disp_custom_ch(IN CONST SEG_LCD_CH_T cus_ch, IN CONST U
  */
 VOID_T __set_seg_lcd_light(IN CONST BOOL_T on_off)
 {
-    sg_seg_lcd_mag.light = on_off;
+    if (sg_seg_lcd_mag.light != on_off) {
+        sg_seg_lcd_mag.light = on_off;
+        __seg_lcd_update_phase();
+    }
 }
 
 /**
@@ -450,20 +565,16 @@ STATIC BOOL_T __get_seg_lcd_flash_end_light(IN CONST SEG_LCD_FLASH_TYPE_E type)
 SEG_LCD_RET tuya_seg_lcd_set_flash(IN CONST UCHAR_T digit, IN CONST SEG_LCD_FLASH_TYPE_E type, IN CONST USHORT_T intv, IN CONST USHORT_T count, IN CONST SEG_LCD_CALLBACK end_cb)
 {
     sg_seg_lcd_mag.stop_flash_req = FALSE;
-    if (sg_seg_lcd_mag.flash == NULL) {
-        SEG_LCD_FLASH_T *seg_lcd_flash = (SEG_LCD_FLASH_T *)tuya_ble_malloc(SIZEOF(SEG_LCD_FLASH_T));
-        if (NULL == seg_lcd_flash) {
-            return SEG_LCD_ERR_MALLOC_FAILED;
-        }
-        sg_seg_lcd_mag.flash = seg_lcd_flash;
-    }
+    sg_seg_lcd_mag.flash = &sg_seg_lcd_mag.flash_s;
     sg_seg_lcd_mag.flash->digit = digit;
     sg_seg_lcd_mag.flash->type = type;
     sg_seg_lcd_mag.flash->intv = intv;
     sg_seg_lcd_mag.flash->count = count;
     sg_seg_lcd_mag.flash->work_timer = 0;
     sg_seg_lcd_mag.flash->end_cb = end_cb;
-    __set_seg_lcd_light(__get_seg_lcd_flash_sta_light(type));
+    /* the flash digit changes the output even if the light does not */
+    sg_seg_lcd_mag.light = __get_seg_lcd_flash_sta_light(type);
+    __seg_lcd_update_phase();
     return SEG_LCD_OK;
 }
 
@@ -517,9 +628,10 @@ STATIC VOID_T __seg_lcd_flash_proc(VOID_T)
 STATIC INT_T __seg_lcd_timeout_handler(VOID_T)
 {
     if (sg_seg_lcd_mag.stop_flash_req) {
-        __set_seg_lcd_light(sg_seg_lcd_mag.stop_flash_light);
-        tuya_ble_free((UCHAR_T *)sg_seg_lcd_mag.flash);
+        /* the output without the flash digit is updated even if the light does not change */
         sg_seg_lcd_mag.flash = NULL;
+        sg_seg_lcd_mag.light = sg_seg_lcd_mag.stop_flash_light;
+        __seg_lcd_update_phase();
         sg_seg_lcd_mag.stop_flash_req = FALSE;
     }
     if (sg_seg_lcd_mag.flash != NULL) {
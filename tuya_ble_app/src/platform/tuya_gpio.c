@@ -10,8 +10,10 @@
  */
 
 #include "tuya_gpio.h"
-#include "tuya_ble_mem.h"
 #include "gpio_8258.h"
+#include "pm.h"
+#include "irq.h"
+#include "timer.h"
 
 /***********************************************************
 ************************micro define************************
@@ -20,11 +22,10 @@
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
-typedef struct ty_gpio_irq_mag_s {
-    struct ty_gpio_irq_mag_s *next;
-    TY_GPIO_PORT_E port;
-    TY_GPIO_IRQ_CB irq_cb;
-} TY_GPIO_IRQ_MAG_T;
+typedef struct {
+    TY_GPIO_IRQ_CB irq_cb[TY_GPIO_MAX];         /* callback indexed by port */
+    UCHAR_T group_mask[TY_GPIO_GROUP_NUM];      /* registered pins of each group */
+} TY_GPIO_IRQ_TABLE_T;
 
 /***********************************************************
 ***********************variable define**********************
@@ -64,8 +65,9 @@ STATIC GPIO_PinTypeDef sg_pf_pin_list[] = {
     GPIO_PD7
 };
 
-STATIC TY_GPIO_IRQ_MAG_T *sg_rise_mag_list = NULL;
-STATIC TY_GPIO_IRQ_MAG_T *sg_fall_mag_list = NULL;
+STATIC TY_GPIO_IRQ_TABLE_T sg_rise_irq_tbl;
+STATIC TY_GPIO_IRQ_TABLE_T sg_fall_irq_tbl;
+STATIC volatile TY_GPIO_IRQ_STAT_T sg_irq_stat;
 
 /***********************************************************
 ***********************function define**********************
@@ -220,6 +222,53 @@ GPIO_RET tuya_gpio_write(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T level)
     return GPIO_OK;
 }
 
+/**
+ * @brief tuya gpio write several pins of a group at once
+ * @param[in] group: gpio group, 0 - A, 1 - B, 2 - C, 3 - D
+ * @param[in] mask: pins to write, bit n is pin n of the group
+ * @param[in] level: output levels, bit n is the level of pin n of the group
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_write_port(IN CONST UCHAR_T group, IN CONST UCHAR_T mask, IN CONST UCHAR_T level)
+{
+    UCHAR_T r;
+
+    if (group >= TY_GPIO_GROUP_NUM) {
+        return GPIO_ERR_INVALID_PARM;
+    }
+
+    /* one write of the output register, the other pins of the group keep their level,
+       the segment lcd scan irq writes the same registers */
+    r = irq_disable();
+    reg_gpio_out(group << 8) = (reg_gpio_out(group << 8) & ~mask) | (level & mask);
+    irq_restore(r);
+
+    return GPIO_OK;
+}
+
+/**
+ * @brief tuya gpio enable or disable the output of several pins of a group at once
+ * @param[in] group: gpio group, 0 - A, 1 - B, 2 - C, 3 - D
+ * @param[in] mask: pins to set, bit n is pin n of the group
+ * @param[in] out_en: output enable, bit n set - pin n is output, bit n clear - pin n is high impedance
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_set_port_output(IN CONST UCHAR_T group, IN CONST UCHAR_T mask, IN CONST UCHAR_T out_en)
+{
+    UCHAR_T r;
+
+    if (group >= TY_GPIO_GROUP_NUM) {
+        return GPIO_ERR_INVALID_PARM;
+    }
+
+    /* the output enable register is active low */
+    r = irq_disable();
+    reg_gpio_oen(group << 8) = (reg_gpio_oen(group << 8) & ~mask) | (~out_en & mask);
+    irq_restore(r);
+
+    return GPIO_OK;
+}
+
 /**
  * @brief tuya gpio read
  * @param[in] port: gpio number
@@ -237,6 +286,45 @@ BOOL_T tuya_gpio_read(IN CONST TY_GPIO_PORT_E port)
     return gpio_read(sg_pf_pin_list[port]);
 }
 
+/**
+ * @brief tuya gpio read all pins of a group at once
+ * @param[in] group: gpio group, 0 - A, 1 - B, 2 - C, 3 - D
+ * @return input levels, bit n is the level of pin n of the group
+ */
+UCHAR_T tuya_gpio_read_port(IN CONST UCHAR_T group)
+{
+    if (group >= TY_GPIO_GROUP_NUM) {
+        return 0;
+    }
+    return reg_gpio_in(group << 8);
+}
+
+/**
+ * @brief gpio interrupt enable
+ * @param[in] port: gpio number
+ * @param[in] trig_type: trigger type
+ * @return none
+ */
+STATIC VOID_T __gpio_irq_enable(IN CONST TY_GPIO_PORT_E port, IN CONST TY_GPIO_IRQ_TYPE_E trig_type)
+{
+    switch (trig_type) {
+    case TY_GPIO_IRQ_RISING:
+        gpio_set_interrupt_pol(sg_pf_pin_list[port], pol_rising);
+	    reg_irq_src = FLD_IRQ_GPIO_RISC0_EN;
+	    reg_irq_mask |= FLD_IRQ_GPIO_RISC0_EN;
+	    gpio_en_interrupt_risc0(sg_pf_pin_list[port], TRUE);
+        break;
+    case TY_GPIO_IRQ_FALLING:
+        gpio_set_interrupt_pol(sg_pf_pin_list[port], pol_falling);
+	    reg_irq_src = FLD_IRQ_GPIO_RISC1_EN;
+	    reg_irq_mask |= FLD_IRQ_GPIO_RISC1_EN;
+	    gpio_en_interrupt_risc1(sg_pf_pin_list[port], TRUE);
+        break;
+    default:
+        break;
+    }
+}
+
 /**
  * @brief tuya gpio interrupt init
  * @param[in] port: gpio number
@@ -253,36 +341,26 @@ GPIO_RET tuya_gpio_irq_init(IN CONST TY_GPIO_PORT_E port, IN CONST TY_GPIO_IRQ_T
         return GPIO_ERR_INVALID_PARM;
     }
 
-    /* allocate and clear for hall_sw_mag */
-    TY_GPIO_IRQ_MAG_T *irq_mag_tmp = (TY_GPIO_IRQ_MAG_T *)tuya_ble_malloc(SIZEOF(TY_GPIO_IRQ_MAG_T));
-    if (NULL == irq_mag_tmp) {
-        return GPIO_ERR_MALLOC_FAILED;
-    }
-    irq_mag_tmp->port = port;
-    irq_mag_tmp->irq_cb = irq_cb;
+    /* the tables are indexed by port, drop any previous trigger so re-init only keeps the new one */
+    sg_rise_irq_tbl.irq_cb[port] = NULL;
+    sg_rise_irq_tbl.group_mask[TY_GPIO_GROUP(port)] &= ~TY_GPIO_BIT(port);
+    sg_fall_irq_tbl.irq_cb[port] = NULL;
+    sg_fall_irq_tbl.group_mask[TY_GPIO_GROUP(port)] &= ~TY_GPIO_BIT(port);
+    gpio_en_interrupt_risc0(sg_pf_pin_list[port], FALSE);
+    gpio_en_interrupt_risc1(sg_pf_pin_list[port], FALSE);
 
     switch (trig_type) {
     case TY_GPIO_IRQ_NONE:
         break;
     case TY_GPIO_IRQ_RISING:
-        if (sg_rise_mag_list) {
-    	    irq_mag_tmp->next = sg_rise_mag_list;
-        }
-        sg_rise_mag_list = irq_mag_tmp;
-        gpio_set_interrupt_pol(sg_pf_pin_list[port], pol_rising);
-	    reg_irq_src = FLD_IRQ_GPIO_RISC0_EN;
-	    reg_irq_mask |= FLD_IRQ_GPIO_RISC0_EN;
-	    gpio_en_interrupt_risc0(sg_pf_pin_list[port], TRUE);
+        sg_rise_irq_tbl.irq_cb[port] = irq_cb;
+        sg_rise_irq_tbl.group_mask[TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+        __gpio_irq_enable(port, trig_type);
         break;
     case TY_GPIO_IRQ_FALLING:
-        if (sg_fall_mag_list) {
-    	    irq_mag_tmp->next = sg_fall_mag_list;
-        }
-        sg_fall_mag_list = irq_mag_tmp;
-        gpio_set_interrupt_pol(sg_pf_pin_list[port], pol_falling);
-	    reg_irq_src = FLD_IRQ_GPIO_RISC1_EN;
-	    reg_irq_mask |= FLD_IRQ_GPIO_RISC1_EN;
-	    gpio_en_interrupt_risc1(sg_pf_pin_list[port], TRUE);
+        sg_fall_irq_tbl.irq_cb[port] = irq_cb;
+        sg_fall_irq_tbl.group_mask[TY_GPIO_GROUP(port)] |= TY_GPIO_BIT(port);
+        __gpio_irq_enable(port, trig_type);
         break;
     default:
         break;
@@ -292,34 +370,53 @@ GPIO_RET tuya_gpio_irq_init(IN CONST TY_GPIO_PORT_E port, IN CONST TY_GPIO_IRQ_T
 }
 
 /**
- * @brief gpio rising irq handler
- * @param[in] none
- * @return none
+ * @brief tuya gpio set as pad wakeup source
+ * @param[in] port: gpio number
+ * @param[in] level: wakeup level
+ * @param[in] en: TRUE - enable, FALSE - disable
+ * @return GPIO_RET
  */
-STATIC VOID_T __gpio_irq_rising_handler(VOID_T)
+GPIO_RET tuya_gpio_set_wakeup(IN CONST TY_GPIO_PORT_E port, IN CONST BOOL_T level, IN CONST BOOL_T en)
 {
-    TY_GPIO_IRQ_MAG_T *irq_mag_tmp = sg_rise_mag_list;
-    while (irq_mag_tmp) {
-        if (gpio_read(sg_pf_pin_list[irq_mag_tmp->port])) {
-            irq_mag_tmp->irq_cb(irq_mag_tmp->port);
-        }
-        irq_mag_tmp = irq_mag_tmp->next;
+    if (port >= TY_GPIO_MAX) {
+        return GPIO_ERR_INVALID_PARM;
+    }
+    if (-1 == sg_pf_pin_list[port]) {
+        return GPIO_ERR_INVALID_PARM;
     }
+
+    cpu_set_gpio_wakeup(sg_pf_pin_list[port], (level) ? Level_High : Level_Low, en);
+    return GPIO_OK;
 }
 
 /**
- * @brief gpio falling irq handler
- * @param[in] none
+ * @brief gpio irq dispatch, one input register read per registered group
+ * @param[in] irq_tbl: gpio interrupt table
+ * @param[in] level: level of the triggered pins, TRUE - high, FALSE - low
  * @return none
  */
-STATIC VOID_T __gpio_irq_falling_handler(VOID_T)
+STATIC VOID_T __gpio_irq_dispatch(IN CONST TY_GPIO_IRQ_TABLE_T *irq_tbl, IN CONST BOOL_T level)
 {
-    TY_GPIO_IRQ_MAG_T *irq_mag_tmp = sg_fall_mag_list;
-    while (irq_mag_tmp) {
-        if (!gpio_read(sg_pf_pin_list[irq_mag_tmp->port])) {
-            irq_mag_tmp->irq_cb(irq_mag_tmp->port);
+    UCHAR_T group, pending;
+    TY_GPIO_PORT_E port;
+
+    for (group = 0; group < TY_GPIO_GROUP_NUM; group++) {
+        if (irq_tbl->group_mask[group] == 0) {
+            continue;
+        }
+        pending = tuya_gpio_read_port(group);
+        if (!level) {
+            pending = ~pending;
+        }
+        pending &= irq_tbl->group_mask[group];
+        port = (TY_GPIO_PORT_E)(group * TY_GPIO_PIN_PER_GROUP);
+        while (pending) {
+            if (pending & 0x01) {
+                irq_tbl->irq_cb[port](port);
+            }
+            pending >>= 1;
+            port++;
         }
-        irq_mag_tmp = irq_mag_tmp->next;
     }
 }
 
@@ -330,12 +427,44 @@ STATIC VOID_T __gpio_irq_falling_handler(VOID_T)
  */
 VOID_T tuya_gpio_irq_handler(VOID_T)
 {
+    UINT_T tm, cost;
+
 	if(reg_irq_src & FLD_IRQ_GPIO_RISC0_EN){
 		reg_irq_src = FLD_IRQ_GPIO_RISC0_EN;
-        __gpio_irq_rising_handler();
+        tm = clock_time();
+        __gpio_irq_dispatch(&sg_rise_irq_tbl, TRUE);
+        cost = clock_time() - tm;
+        sg_irq_stat.cnt++;
+        sg_irq_stat.sum += cost;
+        if (cost > sg_irq_stat.max) {
+            sg_irq_stat.max = cost;
+        }
     }
 	if(reg_irq_src & FLD_IRQ_GPIO_RISC1_EN){
 		reg_irq_src = FLD_IRQ_GPIO_RISC1_EN;
-        __gpio_irq_falling_handler();
+        tm = clock_time();
+        __gpio_irq_dispatch(&sg_fall_irq_tbl, FALSE);
+        cost = clock_time() - tm;
+        sg_irq_stat.cnt++;
+        sg_irq_stat.sum += cost;
+        if (cost > sg_irq_stat.max) {
+            sg_irq_stat.max = cost;
+        }
+    }
+}
+
+/**
+ * @brief get the cost of the gpio irq dispatch
+ * @param[out] stat: dispatch statistics
+ * @return GPIO_RET
+ */
+GPIO_RET tuya_gpio_get_irq_stat(OUT TY_GPIO_IRQ_STAT_T *stat)
+{
+    if (NULL == stat) {
+        return GPIO_ERR_INVALID_PARM;
     }
+    stat->cnt = sg_irq_stat.cnt;
+    stat->sum = sg_irq_stat.sum;
+    stat->max = sg_irq_stat.max;
+    return GPIO_OK;
 }
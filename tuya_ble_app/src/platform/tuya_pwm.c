@@ -0,0 +1,143 @@
+/**
+ * @file tuya_pwm.c
+ * @author lifan
+ * @brief tuya pwm source file for TLSR825x
+ * @version 1.0
+ * @date 2021-09-23
+ *
+ * @copyright Copyright (c) tuya.inc 2021
+ *
+ */
+
+#include "tuya_pwm.h"
+#include "gpio_8258.h"
+#include "pwm.h"
+
+/***********************************************************
+************************micro define************************
+***********************************************************/
+#define TY_PWM_CLOCK_HZ         CLOCK_SYS_CLOCK_HZ
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    TY_GPIO_PORT_E port;        /* gpio number */
+    GPIO_PinTypeDef pin;        /* platform pin */
+    pwm_id id;                  /* pwm channel */
+    GPIO_FuncTypeDef func;      /* pin function of the pwm output */
+    BOOL_T inverted;            /* the output is the inverted channel (PWMx_N) */
+} TY_PWM_PIN_T;
+
+typedef struct {
+    USHORT_T cycle;             /* cycle (pwm clock tick), 0 - not initialized */
+    BOOL_T active_low;
+    BOOL_T running;
+} TY_PWM_STAT_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+/* ports of the hula hoop board that can output pwm */
+STATIC CONST TY_PWM_PIN_T sg_pwm_pin_list[] = {
+    {TY_GPIOD_4, GPIO_PD4, PWM2_ID, AS_PWM2_N, TRUE}
+};
+
+#define TY_PWM_PIN_NUM          (SIZEOF(sg_pwm_pin_list) / SIZEOF(sg_pwm_pin_list[0]))
+
+STATIC TY_PWM_STAT_T sg_pwm_stat[TY_PWM_PIN_NUM];
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+/**
+ * @brief find the pwm pin of a port
+ * @param[in] port: gpio number
+ * @return index in the pwm pin list, TY_PWM_PIN_NUM if the port has no pwm output
+ */
+STATIC UCHAR_T __pwm_find_pin(IN CONST TY_GPIO_PORT_E port)
+{
+    UCHAR_T i;
+    for (i = 0; i < TY_PWM_PIN_NUM; i++) {
+        if (sg_pwm_pin_list[i].port == port) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief tuya pwm init, the output starts off
+ * @param[in] port: gpio number
+ * @param[in] freq: pwm frequency (Hz)
+ * @param[in] active_low: TRUE - active low, FALSE - active high
+ * @return PWM_RET
+ */
+PWM_RET tuya_pwm_init(IN CONST TY_GPIO_PORT_E port, IN CONST UINT_T freq, IN CONST BOOL_T active_low)
+{
+    UCHAR_T idx = __pwm_find_pin(port);
+    UINT_T cycle;
+
+    if ((idx >= TY_PWM_PIN_NUM) || (freq == 0)) {
+        return PWM_ERR_INVALID_PARM;
+    }
+    cycle = TY_PWM_CLOCK_HZ / freq;
+    if ((cycle < TY_PWM_DUTY_MAX) || (cycle > 0xFFFF)) {
+        return PWM_ERR_INVALID_PARM;
+    }
+    /* clock registers are lost in deep retention, set them on every init */
+    pwm_set_clk(CLOCK_SYS_CLOCK_HZ, TY_PWM_CLOCK_HZ);
+
+    sg_pwm_stat[idx].cycle = (USHORT_T)cycle;
+    sg_pwm_stat[idx].active_low = active_low;
+    sg_pwm_stat[idx].running = FALSE;
+    pwm_set_mode(sg_pwm_pin_list[idx].id, PWM_NORMAL_MODE);
+    /* PWMx is high for the compare ticks, revert the output so that the active time is the duty */
+    if (sg_pwm_pin_list[idx].inverted != active_low) {
+        if (sg_pwm_pin_list[idx].inverted) {
+            pwm_n_revert(sg_pwm_pin_list[idx].id);
+        } else {
+            pwm_revert(sg_pwm_pin_list[idx].id);
+        }
+    }
+    pwm_set_cycle_and_duty(sg_pwm_pin_list[idx].id, (USHORT_T)cycle, 0);
+    tuya_gpio_init(port, FALSE, active_low);
+    return PWM_OK;
+}
+
+/**
+ * @brief tuya pwm set duty, 0 and TY_PWM_DUTY_MAX drive the pin as gpio with pwm stopped
+ * @param[in] port: gpio number
+ * @param[in] duty: active duty, 0 ~ TY_PWM_DUTY_MAX
+ * @return PWM_RET
+ */
+PWM_RET tuya_pwm_set_duty(IN CONST TY_GPIO_PORT_E port, IN CONST UCHAR_T duty)
+{
+    UCHAR_T idx = __pwm_find_pin(port);
+    CONST TY_PWM_PIN_T *pwm_pin;
+    TY_PWM_STAT_T *stat;
+
+    if ((idx >= TY_PWM_PIN_NUM) || (sg_pwm_stat[idx].cycle == 0)) {
+        return PWM_ERR_INVALID_PARM;
+    }
+    pwm_pin = &sg_pwm_pin_list[idx];
+    stat = &sg_pwm_stat[idx];
+
+    /* full off and full on need no pwm clock */
+    if ((duty == 0) || (duty == TY_PWM_DUTY_MAX)) {
+        if (stat->running) {
+            pwm_stop(pwm_pin->id);
+            gpio_set_func(pwm_pin->pin, AS_GPIO);
+            stat->running = FALSE;
+        }
+        tuya_gpio_write(port, (duty != 0) ? !stat->active_low : stat->active_low);
+        return PWM_OK;
+    }
+    pwm_set_cmp(pwm_pin->id, (USHORT_T)(((UINT_T)stat->cycle * duty) / TY_PWM_DUTY_MAX));
+    if (!stat->running) {
+        gpio_set_func(pwm_pin->pin, pwm_pin->func);
+        pwm_start(pwm_pin->id);
+        stat->running = TRUE;
+    }
+    return PWM_OK;
+}
@@ -1,6 +1,7 @@
 
 #include "tuya_ble_common.h"
 #include "tuya_ble_mem.h"
+#include "tuya_hula_hoop_evt_user.h"
 
 #define DP_LEN_MAX       220
 #define UART_HEAD_NUM    6
@@ -340,6 +341,7 @@ void tuya_uart_common_handler(u8 *pData,u16 len)
 
 void tuya_uart_debug_handler(u8 *pData,u16 len)
 {
+	hula_hoop_uart_debug_handler(pData,len);
 }
 
 void tuya_uart_rx_handler(u8 *uart_Data,u16 len)
@@ -15,6 +15,7 @@
 #include "tuya_hula_hoop_svc_basic.h"
 #include "tuya_hula_hoop_svc_data.h"
 #include "tuya_hula_hoop_svc_disp.h"
+#include "tuya_hula_hoop_svc_session.h"
 #include "tuya_hula_hoop_ble_proc.h"
 
 /***********************************************************
@@ -43,6 +44,7 @@ VOID_T tuya_hula_hoop_init(VOID_T)
     hula_hoop_key_hall_init();
     hula_hoop_disp_proc_init();
     hula_hoop_data_proc_init();
+    hula_hoop_session_init();
     hula_hoop_ble_proc_init();
     hula_hoop_basic_service_init();
 }
@@ -71,6 +73,7 @@ VOID_T tuya_hula_hoop_init_deepRetn(VOID_T)
  */
 VOID_T tuya_hula_hoop_loop(VOID_T)
 {
+    hula_hoop_key_hall_loop();
     if (hula_hoop_get_device_status() >= STAT_UNUSED) {
         return;
     }
@@ -13,6 +13,7 @@
 #include "tuya_hula_hoop_svc_basic.h"
 #include "tuya_hula_hoop_svc_disp.h"
 #include "tuya_hula_hoop_svc_data.h"
+#include "tuya_hula_hoop_svc_session.h"
 #include "tuya_hula_hoop_evt_timer.h"
 #include "tuya_local_time.h"
 #include "tuya_ble_common.h"
@@ -40,12 +41,18 @@
 #define DP_ID_TIME_TARGET_MONTH     112
 #define DP_ID_TIME_REMAIN_TODAY     113
 #define DP_ID_TIME_REMAIN_MONTH     114
+#define DP_ID_CADENCE_REALTIME      115
+#define DP_ID_SESSION_SETS          116
+#define DP_ID_USER_WEIGHT           117
 
 #define DP_DATA_INDEX_OFFSET_ID     0
 #define DP_DATA_INDEX_OFFSET_TYPE   1
 #define DP_DATA_INDEX_OFFSET_LEN    2
 #define DP_DATA_INDEX_OFFSET_DATA   3
 
+/* raw data of one set: start time(3), duration(2), count(2), cadence(2), rest(2) */
+#define SESSION_SET_RAW_LEN         11
+
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
@@ -187,6 +194,7 @@ VOID_T __report_sport_data_realtime(VOID_T)
     UCHAR_T total_len = 0;
     total_len += __add_one_dp_data(DP_ID_TIME_REALTIME, DT_VALUE, SIZEOF(g_sport_data.time_realtime), (UCHAR_T *)&g_sport_data.time_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_COUNT_REALTIME, DT_VALUE, SIZEOF(g_sport_data.count_realtime), (UCHAR_T *)&g_sport_data.count_realtime, (sg_repo_array + total_len));
+    total_len += __add_one_dp_data(DP_ID_CADENCE_REALTIME, DT_VALUE, SIZEOF(g_sport_data.cadence_realtime), (UCHAR_T *)&g_sport_data.cadence_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_CALORIES_REALTIME, DT_VALUE, SIZEOF(g_sport_data.calories_realtime), (UCHAR_T *)&g_sport_data.calories_realtime, (sg_repo_array + total_len));
     tuya_ble_dp_data_report(sg_repo_array, total_len);
 }
@@ -227,6 +235,7 @@ VOID_T hula_hoop_report_sport_data2(VOID_T)
 {
     UCHAR_T total_len = 0;
     total_len += __add_one_dp_data(DP_ID_COUNT_REALTIME, DT_VALUE, SIZEOF(g_sport_data.count_realtime), (UCHAR_T *)&g_sport_data.count_realtime, (sg_repo_array + total_len));
+    total_len += __add_one_dp_data(DP_ID_CADENCE_REALTIME, DT_VALUE, SIZEOF(g_sport_data.cadence_realtime), (UCHAR_T *)&g_sport_data.cadence_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_CALORIES_REALTIME, DT_VALUE, SIZEOF(g_sport_data.calories_realtime), (UCHAR_T *)&g_sport_data.calories_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_COUNT_TOTAL_TODAY, DT_VALUE, SIZEOF(g_sport_data.count_total_today), (UCHAR_T *)&g_sport_data.count_total_today, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_CALORIES_TOTAL_TODAY, DT_VALUE, SIZEOF(g_sport_data.calories_total_today), (UCHAR_T *)&g_sport_data.calories_total_today, (sg_repo_array + total_len));
@@ -243,9 +252,11 @@ VOID_T hula_hoop_report_sport_data2(VOID_T)
 STATIC VOID_T __report_all_dp_data(VOID_T)
 {
     UCHAR_T total_len = 0;
+    UINT_T weight = hula_hoop_get_user_weight();
     total_len += __add_one_dp_data(DP_ID_MODE, DT_ENUM, SIZEOF(g_hula_hoop.mode), &g_hula_hoop.mode, sg_repo_array);
     total_len += __add_one_dp_data(DP_ID_TIME_REALTIME, DT_VALUE, SIZEOF(g_sport_data.time_realtime), (UCHAR_T *)&g_sport_data.time_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_COUNT_REALTIME, DT_VALUE, SIZEOF(g_sport_data.count_realtime), (UCHAR_T *)&g_sport_data.count_realtime, (sg_repo_array + total_len));
+    total_len += __add_one_dp_data(DP_ID_CADENCE_REALTIME, DT_VALUE, SIZEOF(g_sport_data.cadence_realtime), (UCHAR_T *)&g_sport_data.cadence_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_CALORIES_REALTIME, DT_VALUE, SIZEOF(g_sport_data.calories_realtime), (UCHAR_T *)&g_sport_data.calories_realtime, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_TIME_TOTAL_TODAY, DT_VALUE, SIZEOF(g_sport_data.time_total_today), (UCHAR_T *)&g_sport_data.time_total_today, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_COUNT_TOTAL_TODAY, DT_VALUE, SIZEOF(g_sport_data.count_total_today), (UCHAR_T *)&g_sport_data.count_total_today, (sg_repo_array + total_len));
@@ -255,9 +266,42 @@ STATIC VOID_T __report_all_dp_data(VOID_T)
     total_len += __add_one_dp_data(DP_ID_CALORIES_TOTAL_30DAYS, DT_VALUE, SIZEOF(g_sport_data.calories_total_30days), (UCHAR_T *)&g_sport_data.calories_total_30days, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_TIME_REMAIN_TODAY, DT_VALUE, SIZEOF(g_sport_data.time_remain_today), (UCHAR_T *)&g_sport_data.time_remain_today, (sg_repo_array + total_len));
     total_len += __add_one_dp_data(DP_ID_TIME_REMAIN_MONTH, DT_VALUE, SIZEOF(g_sport_data.time_remain_month), (UCHAR_T *)&g_sport_data.time_remain_month, (sg_repo_array + total_len));
+    total_len += __add_one_dp_data(DP_ID_USER_WEIGHT, DT_VALUE, SIZEOF(weight), (UCHAR_T *)&weight, (sg_repo_array + total_len));
     tuya_ble_dp_data_report(sg_repo_array, total_len);
 }
 
+/**
+ * @brief report dp data of the sets of the last workout session
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __report_session_data(VOID_T)
+{
+    UCHAR_T i, num;
+    UCHAR_T *p_data = sg_repo_array + DP_DATA_INDEX_OFFSET_DATA;
+    CONST SESSION_SET_T *set;
+
+    num = hula_hoop_get_session_set_num();
+    for (i = 0; i < num; i++) {
+        set = hula_hoop_get_session_set(i);
+        *p_data++ = (UCHAR_T)(set->start_time >> 16);
+        *p_data++ = (UCHAR_T)(set->start_time >> 8);
+        *p_data++ = (UCHAR_T)(set->start_time);
+        *p_data++ = (UCHAR_T)(set->duration >> 8);
+        *p_data++ = (UCHAR_T)(set->duration);
+        *p_data++ = (UCHAR_T)(set->count >> 8);
+        *p_data++ = (UCHAR_T)(set->count);
+        *p_data++ = (UCHAR_T)(set->cadence >> 8);
+        *p_data++ = (UCHAR_T)(set->cadence);
+        *p_data++ = (UCHAR_T)(set->rest >> 8);
+        *p_data++ = (UCHAR_T)(set->rest);
+    }
+    sg_repo_array[DP_DATA_INDEX_OFFSET_ID] = DP_ID_SESSION_SETS;
+    sg_repo_array[DP_DATA_INDEX_OFFSET_TYPE] = DT_RAW;
+    sg_repo_array[DP_DATA_INDEX_OFFSET_LEN] = num * SESSION_SET_RAW_LEN;
+    tuya_ble_dp_data_report(sg_repo_array, num * SESSION_SET_RAW_LEN + 3);
+}
+
 /**
  * @brief dp data handler
  * @param[in] dp_data: dp data array
@@ -291,6 +335,15 @@ VOID_T hula_hoop_ble_dp_write_handler(IN UCHAR_T *dp_data)
             TUYA_APP_LOG_INFO("APP set this month's target : %dmin.", tar_tm);
         }
         break;
+    case DP_ID_USER_WEIGHT:
+        {
+            UINT_T weight = (((UINT_T)dp_data[3]) << 24) | (((UINT_T)dp_data[4]) << 16) | (((UINT_T)dp_data[5]) << 8) | ((UINT_T)dp_data[6]);
+            hula_hoop_set_user_weight(weight);
+            weight = hula_hoop_get_user_weight();
+            __report_one_dp_data(DP_ID_USER_WEIGHT, DT_VALUE, SIZEOF(weight), (UCHAR_T *)&weight);
+            TUYA_APP_LOG_INFO("APP set the user's weight : %dkg.", weight);
+        }
+        break;
     default:
         break;
     }
@@ -311,6 +364,7 @@ VOID_T hula_hoop_ble_conn_stat_handler(IN CONST tuya_ble_connect_status_t status
     }
     if (status == BONDING_CONN) {
         __report_all_dp_data();
+        __report_session_data();
         tuya_ble_time_req(BLE_TIME_TYPE_NORMAL);
         if (F_WAIT_BINDING == SET) {
             F_BLE_BOUND = SET;
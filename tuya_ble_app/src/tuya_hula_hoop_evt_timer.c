@@ -10,9 +10,11 @@
  */
 
 #include "tuya_hula_hoop_evt_timer.h"
+#include "tuya_hula_hoop_evt_user.h"
 #include "tuya_hula_hoop_svc_basic.h"
 #include "tuya_hula_hoop_svc_data.h"
 #include "tuya_hula_hoop_svc_disp.h"
+#include "tuya_hula_hoop_svc_session.h"
 #include "tuya_hula_hoop_ble_proc.h"
 #include "tuya_local_time.h"
 #include "tuya_timer.h"
@@ -24,10 +26,13 @@
 #define TIMER_PERIOD_MS                 (100)       /* 100ms */
 #define DISP_SLEEP_CONFIRM_TIME_MS      (6*1000)    /* 6s */
 #define DISP_WAKEUP_CONFIRM_TIME_MS     (5*60*1000) /* 5min */
-#define STOP_ROTATING_CONFIRM_TIME_MS   (3000)      /* 3s */
+#define STOP_ROTATING_CONFIRM_TIME_MS   (3000)      /* 3s, used when the rotation period is unknown */
+#define STOP_ROTATING_CONFIRM_MIN_MS    (500)       /* 0.5s */
+#define STOP_ROTATING_PERIOD_MULTIPLE   (3)         /* confirm after 3 missing rotations */
 #define STOP_USING_CONFIRM_TIME_MS      (30*1000)   /* 30s */
 #define DISP_DATA_SWITCH_INTV_MS        (2000)      /* 2s */
 #define TIME_DATA_UPDATE_INTV_MS        (1*60*1000) /* 1min */
+#define CADENCE_DATA_UPDATE_INTV_MS     (1000)      /* 1s */
 #define LOCAL_TIME_UPDATE_INTV_MS       (1000)      /* 1s */
 #define DP_DATA_REPO_INTV_MS            (5*1000)    /* 5s */
 #define WAIT_BIND_END_TIME_MS           (1*60*1000) /* 1min */
@@ -42,6 +47,7 @@ typedef struct {
     UINT_T stop_using;
     UINT_T switch_disp_data;
     UINT_T upd_time_data;
+    UINT_T upd_cadence_data;
     UINT_T upd_local_time;
     UINT_T repo_dp_data;
     UINT_T wait_bind;
@@ -95,6 +101,29 @@ STATIC VOID_T __disp_wakeup_timer(IN CONST UINT_T time_inc)
     }
 }
 
+/**
+ * @brief get stop rotating confirm time from the rotation period
+ * @param[in] period: average rotation period (us), 0 means unknown
+ * @return confirm time (ms)
+ */
+UINT_T hula_hoop_get_stop_rotating_confirm_time(IN CONST UINT_T period)
+{
+    UINT_T confirm_time;
+
+    if (period == 0) {
+        return STOP_ROTATING_CONFIRM_TIME_MS;
+    }
+    confirm_time = (period / 1000) * STOP_ROTATING_PERIOD_MULTIPLE;
+    if (confirm_time < STOP_ROTATING_CONFIRM_MIN_MS) {
+        confirm_time = STOP_ROTATING_CONFIRM_MIN_MS;
+    } else if (confirm_time > STOP_ROTATING_CONFIRM_TIME_MS) {
+        confirm_time = STOP_ROTATING_CONFIRM_TIME_MS;
+    } else {
+        ;
+    }
+    return confirm_time;
+}
+
 /**
  * @brief stop rotating confirm timer
  * @param[in] time_inc: time increment
@@ -107,7 +136,7 @@ STATIC VOID_T __stop_rotating_timer(IN CONST UINT_T time_inc)
         return;
     }
     sg_timer.stop_rotating += time_inc;
-    if (sg_timer.stop_rotating >= STOP_ROTATING_CONFIRM_TIME_MS) {
+    if (sg_timer.stop_rotating >= hula_hoop_get_stop_rotating_confirm_time(hula_hoop_get_rotation_period())) {
         sg_timer.stop_rotating = 0;
         hula_hoop_set_device_status(STAT_USING);
     }
@@ -174,6 +203,24 @@ STATIC VOID_T __upd_time_data_timer(IN CONST UINT_T time_inc)
     }
 }
 
+/**
+ * @brief update cadence data timer
+ * @param[in] time_inc: time increment
+ * @return none
+ */
+STATIC VOID_T __upd_cadence_data_timer(IN CONST UINT_T time_inc)
+{
+    sg_timer.upd_cadence_data += time_inc;
+    if (sg_timer.upd_cadence_data >= CADENCE_DATA_UPDATE_INTV_MS) {
+        sg_timer.upd_cadence_data -= CADENCE_DATA_UPDATE_INTV_MS;
+        if (hula_hoop_get_device_status() == STAT_ROTATING) {
+            hula_hoop_update_sport_data_cadence(hula_hoop_get_rotation_period());
+        } else {
+            hula_hoop_update_sport_data_cadence(0);
+        }
+    }
+}
+
 /**
  * @brief update local time timer
  * @param[in] time_inc: time increment
@@ -234,9 +281,11 @@ STATIC INT_T __timer_timeout_handler(VOID_T)
     __stop_using_timer(TIMER_PERIOD_MS);
     __switch_disp_data_timer(TIMER_PERIOD_MS);
     __upd_time_data_timer(TIMER_PERIOD_MS);
+    __upd_cadence_data_timer(TIMER_PERIOD_MS);
     __upd_local_time_timer(TIMER_PERIOD_MS);
     __repo_dp_data_timer(TIMER_PERIOD_MS);
     __wait_bind_timer(TIMER_PERIOD_MS);
+    hula_hoop_session_update_time(TIMER_PERIOD_MS);
     return 0;
 }
 
@@ -14,18 +14,66 @@
 #include "tuya_hula_hoop_svc_basic.h"
 #include "tuya_hula_hoop_svc_disp.h"
 #include "tuya_hula_hoop_svc_data.h"
+#include "tuya_hula_hoop_svc_session.h"
 #include "tuya_hula_hoop_ble_proc.h"
 #include "tuya_key.h"
 #include "tuya_hall_sw.h"
+#include "tuya_timer.h"
 #include "tuya_ble_log.h"
+#include "tuya_ble_common.h"
 
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
+/* UART debug frame: 0x77 0xAA version type len(2) data checksum */
+#define DEBUG_FRAME_OFFSET_TYPE         3
+#define DEBUG_FRAME_OFFSET_DATA         6
+#define DEBUG_FRAME_LEN_MIN             7
+
+/* UART debug command */
+#define DEBUG_CMD_HALL_TRACE_DUMP       0x01
+#define DEBUG_CMD_HALL_TRACE_REPLAY     0x02
+#define DEBUG_CMD_HALL_STAT             0x03
+#define DEBUG_CMD_HALL_BENCH            0x04
+#define DEBUG_CMD_KEY_LATENCY           0x05
+#define DEBUG_CMD_HALL_QUEUE_TEST       0x06
+#define DEBUG_CMD_STOP_CONFIRM          0x07
+
+#define DEBUG_TRACE_EDGES_PER_FRAME     64
+
+/* edge queue stress test, TY_TIMER_0 scans the segment lcd */
+#define DEBUG_QUEUE_TEST_TIMER          TY_TIMER_1
+#define DEBUG_QUEUE_TEST_INTV_US        20
+#define DEBUG_QUEUE_TEST_BURST          4
+#define DEBUG_QUEUE_TEST_NUM            100000
+
+/* synthetic hall signal benchmark, times in trace unit (HALL_SW_TRACE_UNIT_US) */
+#define BENCH_EDGES_PER_ROTATION_MAX    5       /* main edge, bounce and vibration burst */
+#define BENCH_VIBRATION_EDGES           3
+#define BENCH_BOUNCE_MIN                32      /* 2ms */
+#define BENCH_BOUNCE_RANGE              128     /* up to 10ms */
+#define BENCH_REPLAY_CHUNK              32
+
+/* stop rotating confirm check, steady rotations replayed before the hoop stops */
+#define STOP_CHECK_EDGES_MAX            16
 
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
+typedef struct {
+    USHORT_T rpm;
+    USHORT_T rotations;
+    UCHAR_T jitter;                 /* period jitter (%) */
+    UCHAR_T bounce;                 /* probability of a bounce edge after the main edge (%) */
+    UCHAR_T dropout;                /* probability of a missed main edge (%) */
+    UCHAR_T vibration;              /* probability of a vibration burst in one rotation (%) */
+} HALL_BENCH_SCENE_T;
+
+typedef struct {
+    USHORT_T rpm;
+    UCHAR_T edges;                  /* edges before the stop, too few leave the period unknown */
+    USHORT_T confirm_ms;            /* expected stop rotating confirm time */
+} STOP_CHECK_SCENE_T;
 
 /***********************************************************
 ***********************variable define**********************
@@ -33,7 +81,7 @@
 /* Key and Hall sensor define */
 STATIC VOID_T __mode_key_cb(KEY_PRESS_TYPE_E type);
 STATIC VOID_T __reset_key_cb(KEY_PRESS_TYPE_E type);
-STATIC VOID_T __hall_sw_cb();
+STATIC VOID_T __hall_sw_cb(UINT_T edge_tm);
 KEY_DEF_T mode_key_def_s = {
     .port = TY_GPIOB_7,
     .active_low = TRUE,
@@ -52,9 +100,34 @@ HALL_SW_DEF_T hall_sw_def_s = {
     .port = TY_GPIOD_2,
     .active_low = FALSE,
     .hall_sw_cb = __hall_sw_cb,
-    .invalid_intv = 200000
+    .invalid_intv = 60000,
+    .invalid_intv_max = 400000,
+    .invalid_ratio = 128
 };
 
+/* Synthetic hall signal benchmark scenes */
+STATIC CONST HALL_BENCH_SCENE_T sg_bench_scene[] = {
+    /* rpm, rotations, jitter, bounce, dropout, vibration */
+    {30,  60,  5,  0,  0, 0},
+    {120, 200, 5,  0,  0, 0},
+    {400, 400, 5,  0,  0, 0},
+    {120, 200, 15, 0,  0, 0},
+    {200, 300, 5,  30, 0, 0},
+    {200, 300, 5,  0,  2, 0},
+    {120, 200, 5,  0,  0, 10},
+    {400, 400, 10, 20, 1, 5}
+};
+STATIC CONST STOP_CHECK_SCENE_T sg_stop_check_scene[] = {
+    /* rpm, edges, confirm_ms */
+    {40,  12, 3000},                /* slow: 3 periods are 4.5s, clamped to the maximum */
+    {75,  12, 2400},                /* slow: 3 periods of 800ms */
+    {300, 16, 600},                 /* fast: 3 periods of 200ms */
+    {480, 16, 500},                 /* fast: 3 periods are 375ms, clamped to the minimum */
+    {75,  3,  3000}                 /* stopped before the period was learned */
+};
+STATIC UINT_T sg_bench_seed = 1;
+STATIC USHORT_T sg_bench_counted = 0;
+
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
@@ -91,7 +164,68 @@ VOID_T hula_hoop_key_hall_init(VOID_T)
 VOID_T hula_hoop_key_hall_init_deepRetn(VOID_T)
 {
     tuya_key_reset();
-    tuya_hall_sw_reset();
+    /* hall sensor is re-initialized earlier in hula_hoop_hall_wakeup_handler() */
+}
+
+/**
+ * @brief key latency process after the display is refreshed, called when the segment lcd is rendered
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_key_disp_refreshed(VOID_T)
+{
+    tuya_key_latency_mark_disp();
+}
+
+/**
+ * @brief set hall sensor as wakeup source, called before sleep
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_hall_set_wakeup(VOID_T)
+{
+    tuya_hall_sw_set_wakeup();
+}
+
+/**
+ * @brief hall sensor wakeup handler, called first after pad wakeup
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_hall_wakeup_handler(VOID_T)
+{
+    tuya_hall_sw_wakeup_handler();
+}
+
+/**
+ * @brief key wakeup handler, called after pad wakeup
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_key_wakeup_handler(VOID_T)
+{
+    tuya_key_wakeup_handler();
+}
+
+/**
+ * @brief get the average rotation period measured by hall sensor
+ * @param[in] none
+ * @return average rotation period (us), 0 means unknown
+ */
+UINT_T hula_hoop_get_rotation_period(VOID_T)
+{
+    return tuya_hall_sw_get_period(hall_sw_def_s.port);
+}
+
+/**
+ * @brief key and hall sensor process, called in main loop
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_key_hall_loop(VOID_T)
+{
+    tuya_key_loop();
+    tuya_hall_sw_loop();
 }
 
 /**
@@ -161,13 +295,14 @@ STATIC VOID_T __reset_key_long_press_handler(VOID_T)
 
 /**
  * @brief hall switch handler
- * @param[in] none
+ * @param[in] age_ms: time from the rotation edge to now (ms)
  * @return none
  */
-STATIC VOID_T __hall_switch_handler(VOID_T)
+STATIC VOID_T __hall_switch_handler(IN CONST UINT_T age_ms)
 {
     hula_hoop_update_sport_data_count();
     hula_hoop_update_sport_data_calories();
+    hula_hoop_session_on_rotation(age_ms);
     hula_hoop_set_device_status(STAT_ROTATING);
     hula_hoop_reset_timer_for_hall_event();
 }
@@ -188,6 +323,18 @@ STATIC BOOL_T __key_event_handler(VOID_T)
     return FALSE;
 }
 
+/**
+ * @brief keep the display latency of a key event only if its action changed the lcd content
+ * @param[in] render_key: render key before the key event was handled
+ * @return none
+ */
+STATIC VOID_T __key_disp_latency_check(IN CONST UINT_T render_key)
+{
+    if (hula_hoop_get_disp_render_key() == render_key) {
+        tuya_key_latency_cancel_disp();
+    }
+}
+
 /**
  * @brief mode key callback function
  * @param[in] type: key event type
@@ -195,9 +342,11 @@ STATIC BOOL_T __key_event_handler(VOID_T)
  */
 STATIC VOID_T __mode_key_cb(KEY_PRESS_TYPE_E type)
 {
+    UINT_T render_key = hula_hoop_get_disp_render_key();
     BOOL_T ret = __key_event_handler();
     if ((ret) &&
         (type == SHORT_PRESS)) {
+        __key_disp_latency_check(render_key);
         return;
     }
 
@@ -217,6 +366,7 @@ STATIC VOID_T __mode_key_cb(KEY_PRESS_TYPE_E type)
     default:
         break;
     }
+    __key_disp_latency_check(render_key);
 }
 
 /**
@@ -226,9 +376,11 @@ STATIC VOID_T __mode_key_cb(KEY_PRESS_TYPE_E type)
  */
 STATIC VOID_T __reset_key_cb(KEY_PRESS_TYPE_E type)
 {
+    UINT_T render_key = hula_hoop_get_disp_render_key();
     BOOL_T ret = __key_event_handler();
     if ((ret) &&
         (type == SHORT_PRESS)) {
+        __key_disp_latency_check(render_key);
         return;
     }
 
@@ -246,14 +398,460 @@ STATIC VOID_T __reset_key_cb(KEY_PRESS_TYPE_E type)
     default:
         break;
     }
+    __key_disp_latency_check(render_key);
 }
 
 /**
  * @brief hall switch callback function
+ * @param[in] edge_tm: clock time of the rotation edge
+ * @return none
+ */
+STATIC VOID_T __hall_sw_cb(UINT_T edge_tm)
+{
+    __hall_switch_handler((tuya_get_clock_time() - edge_tm) / (TY_CLOCK_TICK_PER_US * 1000));
+}
+
+/**
+ * @brief put a 32-bit value into a buffer in big-endian
+ * @param[out] buf: output buffer
+ * @param[in] val: value
+ * @return next write address
+ */
+STATIC UCHAR_T *__debug_put_u32(OUT UCHAR_T *buf, IN CONST UINT_T val)
+{
+    *buf++ = (UCHAR_T)(val >> 24);
+    *buf++ = (UCHAR_T)(val >> 16);
+    *buf++ = (UCHAR_T)(val >> 8);
+    *buf++ = (UCHAR_T)(val);
+    return buf;
+}
+
+/**
+ * @brief counting callback of the trace replay, keeps replayed rotations out of the sport data
  * @param[in] none
  * @return none
  */
-STATIC VOID_T __hall_sw_cb()
+STATIC VOID_T __debug_replay_cb(UINT_T edge_tm)
 {
-    __hall_switch_handler();
+    ;
+}
+
+/**
+ * @brief send hall sensor statistics over UART debug channel
+ * @param[in] type: DEBUG_CMD_HALL_STAT - live statistics, DEBUG_CMD_HALL_TRACE_REPLAY - replay statistics
+ * @return none
+ */
+STATIC VOID_T __debug_send_hall_stat(IN CONST UCHAR_T type)
+{
+    HALL_SW_STAT_T stat;
+    TY_GPIO_IRQ_STAT_T irq_stat;
+    UCHAR_T buf[49];
+    UCHAR_T *p_buf = buf;
+
+    if (type == DEBUG_CMD_HALL_TRACE_REPLAY) {
+        tuya_hall_sw_get_replay_stat(&stat);
+    } else {
+        tuya_hall_sw_get_stat(&stat);
+    }
+    p_buf = __debug_put_u32(p_buf, stat.edge_cnt);
+    p_buf = __debug_put_u32(p_buf, stat.overflow_cnt);
+    *p_buf++ = stat.max_depth;
+    p_buf = __debug_put_u32(p_buf, stat.accepted_cnt);
+    p_buf = __debug_put_u32(p_buf, stat.rejected_cnt);
+    p_buf = __debug_put_u32(p_buf, stat.wake_edge_cnt);
+    p_buf = __debug_put_u32(p_buf, stat.wake_latency_last);
+    p_buf = __debug_put_u32(p_buf, stat.wake_latency_max);
+    p_buf = __debug_put_u32(p_buf, stat.wake_hold_last);
+    p_buf = __debug_put_u32(p_buf, stat.wake_hold_max);
+    if (type == DEBUG_CMD_HALL_STAT) {
+        /* gpio irq dispatch: count, average and maximum clock ticks */
+        tuya_gpio_get_irq_stat(&irq_stat);
+        p_buf = __debug_put_u32(p_buf, irq_stat.cnt);
+        p_buf = __debug_put_u32(p_buf, (irq_stat.cnt) ? (irq_stat.sum / irq_stat.cnt) : 0);
+        p_buf = __debug_put_u32(p_buf, irq_stat.max);
+    }
+    ty_uart_debug_send(type, buf, (p_buf - buf));
+}
+
+/**
+ * @brief put key latency counters into a debug frame buffer
+ * @param[out] buf: buffer
+ * @param[in] lat: latency counters
+ * @return next write address
+ */
+STATIC UCHAR_T *__debug_put_key_latency(OUT UCHAR_T *buf, IN CONST KEY_LATENCY_T *lat)
+{
+    UCHAR_T i;
+
+    buf = __debug_put_u32(buf, lat->cnt);
+    buf = __debug_put_u32(buf, lat->min);
+    buf = __debug_put_u32(buf, (lat->cnt) ? (lat->sum / lat->cnt) : 0);
+    buf = __debug_put_u32(buf, lat->max);
+    for (i = 0; i < KEY_LATENCY_HIST_NUM; i++) {
+        *buf++ = (UCHAR_T)(lat->hist[i] >> 8);
+        *buf++ = (UCHAR_T)(lat->hist[i]);
+    }
+    return buf;
+}
+
+/**
+ * @brief send key latency statistics over UART debug channel, one frame per key and event type
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __debug_send_key_latency(VOID_T)
+{
+    /* frame data: total(1), index(1), port(1), type(1), callback and display latency */
+    UCHAR_T buf[4 + (16 + KEY_LATENCY_HIST_NUM * 2) * 2];
+    UCHAR_T *p_buf;
+    KEY_LATENCY_STAT_T stat;
+    UCHAR_T total = tuya_key_get_latency_num();
+    UCHAR_T idx = 0;
+
+    do {
+        p_buf = buf;
+        *p_buf++ = total;
+        *p_buf++ = idx;
+        if (KEY_OK == tuya_key_get_latency(idx, &stat)) {
+            *p_buf++ = stat.port;
+            *p_buf++ = stat.type;
+            p_buf = __debug_put_key_latency(p_buf, &stat.cb);
+            p_buf = __debug_put_key_latency(p_buf, &stat.disp);
+        }
+        ty_uart_debug_send(DEBUG_CMD_KEY_LATENCY, buf, (p_buf - buf));
+        idx++;
+    } while (idx < total);
+}
+
+/**
+ * @brief dump hall edge trace over UART debug channel
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __debug_dump_hall_trace(VOID_T)
+{
+    /* frame data: total(2), index of the first edge(2), unit(1), intervals */
+    UCHAR_T buf[5 + DEBUG_TRACE_EDGES_PER_FRAME * 2];
+    USHORT_T total = tuya_hall_sw_trace_get_num();
+    USHORT_T idx = 0, num;
+
+    do {
+        num = tuya_hall_sw_trace_read(idx, buf + 5, DEBUG_TRACE_EDGES_PER_FRAME);
+        buf[0] = (UCHAR_T)(total >> 8);
+        buf[1] = (UCHAR_T)(total);
+        buf[2] = (UCHAR_T)(idx >> 8);
+        buf[3] = (UCHAR_T)(idx);
+        buf[4] = HALL_SW_TRACE_UNIT_US;
+        ty_uart_debug_send(DEBUG_CMD_HALL_TRACE_DUMP, buf, 5 + num * 2);
+        idx += num;
+    } while (idx < total);
+}
+
+/**
+ * @brief send the edge queue stress test result over UART debug channel
+ * @param[in] res: test result
+ * @return none
+ */
+STATIC VOID_T __debug_queue_test_done(IN CONST HALL_SW_QTEST_T *res)
+{
+    /* frame data: ret(1), pass(1), num, pushed, overflow, popped, lost, disorder, max depth(1) */
+    UCHAR_T buf[27];
+    UCHAR_T *p_buf = buf;
+
+    *p_buf++ = HSW_OK;
+    *p_buf++ = res->pass;
+    p_buf = __debug_put_u32(p_buf, res->num);
+    p_buf = __debug_put_u32(p_buf, res->pushed);
+    p_buf = __debug_put_u32(p_buf, res->overflow);
+    p_buf = __debug_put_u32(p_buf, res->popped);
+    p_buf = __debug_put_u32(p_buf, res->lost);
+    p_buf = __debug_put_u32(p_buf, res->disorder);
+    *p_buf++ = res->max_depth;
+    ty_uart_debug_send(DEBUG_CMD_HALL_QUEUE_TEST, buf, (p_buf - buf));
+    TUYA_APP_LOG_INFO("Queue test %s: pushed %d, overflow %d, popped %d, lost %d, disorder %d.",
+                      (res->pass) ? "pass" : "FAIL", res->pushed, res->overflow, res->popped, res->lost, res->disorder);
+}
+
+/**
+ * @brief start the edge queue stress test, the result is sent when the queue is drained
+ * @param[in] data: intv_us(2), burst(1), num(4), all optional
+ * @param[in] len: data length
+ * @return none
+ */
+STATIC VOID_T __debug_start_queue_test(IN CONST UCHAR_T *data, IN CONST USHORT_T len)
+{
+    UINT_T intv_us = DEBUG_QUEUE_TEST_INTV_US;
+    UCHAR_T burst = DEBUG_QUEUE_TEST_BURST;
+    UINT_T num = DEBUG_QUEUE_TEST_NUM;
+    UCHAR_T ret;
+
+    if (len >= 2) {
+        intv_us = ((UINT_T)data[0] << 8) | data[1];
+    }
+    if (len >= 3) {
+        burst = data[2];
+    }
+    if (len >= 7) {
+        num = ((UINT_T)data[3] << 24) | ((UINT_T)data[4] << 16) | ((UINT_T)data[5] << 8) | data[6];
+    }
+    ret = tuya_hall_sw_queue_test_start(DEBUG_QUEUE_TEST_TIMER, intv_us, burst, num, __debug_queue_test_done);
+    if (HSW_OK != ret) {
+        ty_uart_debug_send(DEBUG_CMD_HALL_QUEUE_TEST, &ret, 1);
+    }
+}
+
+/**
+ * @brief pseudo random number of the benchmark, repeatable for the same seed
+ * @param[in] none
+ * @return random number
+ */
+STATIC UINT_T __bench_rand(VOID_T)
+{
+    sg_bench_seed ^= sg_bench_seed << 13;
+    sg_bench_seed ^= sg_bench_seed >> 17;
+    sg_bench_seed ^= sg_bench_seed << 5;
+    return sg_bench_seed;
+}
+
+/**
+ * @brief generate the edges of one rotation
+ * @param[in] scene: benchmark scene
+ * @param[in] span: shortest rotation after jitter (trace unit), every edge stays below it
+ * @param[out] edge: edge offsets from the start of the rotation, sorted
+ * @return number of edges
+ */
+STATIC UCHAR_T __bench_gen_rotation(IN CONST HALL_BENCH_SCENE_T *scene, IN CONST UINT_T span, OUT UINT_T *edge)
+{
+    UCHAR_T num = 0, i, j;
+    UINT_T tmp;
+
+    if ((__bench_rand() % 100) >= scene->dropout) {
+        edge[num++] = 0;
+        if ((__bench_rand() % 100) < scene->bounce) {
+            edge[num++] = BENCH_BOUNCE_MIN + (__bench_rand() % BENCH_BOUNCE_RANGE);
+        }
+    }
+    if ((__bench_rand() % 100) < scene->vibration) {
+        for (i = 0; i < BENCH_VIBRATION_EDGES; i++) {
+            edge[num++] = __bench_rand() % span;
+        }
+    }
+    for (i = 1; i < num; i++) {
+        tmp = edge[i];
+        for (j = i; (j > 0) && (edge[j - 1] > tmp); j--) {
+            edge[j] = edge[j - 1];
+        }
+        edge[j] = tmp;
+    }
+    return num;
+}
+
+/**
+ * @brief counting callback of the benchmark, the sport data is never touched
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __bench_count_cb(UINT_T edge_tm)
+{
+    sg_bench_counted++;
+}
+
+/**
+ * @brief replay the generated edges through the hall switch driver
+ * @param[in] buf: edges in the trace format
+ * @param[in] num: number of edges
+ * @param[in] restart: restart the edge processing
+ * @return clock ticks spent
+ */
+STATIC UINT_T __bench_replay(IN CONST UCHAR_T *buf, IN CONST USHORT_T num, IN CONST BOOL_T restart)
+{
+    UINT_T tm = tuya_get_clock_time();
+    tuya_hall_sw_trace_replay(hall_sw_def_s.port, buf, num, restart, __bench_count_cb);
+    return (tuya_get_clock_time() - tm);
+}
+
+/**
+ * @brief run one benchmark scene and send the result over UART debug channel
+ * @param[in] idx: scene index
+ * @return none
+ */
+STATIC VOID_T __bench_run_scene(IN CONST UCHAR_T idx)
+{
+    CONST HALL_BENCH_SCENE_T *scene = &sg_bench_scene[idx];
+    UCHAR_T buf[BENCH_REPLAY_CHUNK * 2];
+    UINT_T edge[BENCH_EDGES_PER_ROTATION_MAX];
+    UINT_T period, jitter, span, base, last, t, intv, ticks = 0, counted;
+    USHORT_T r, edges = 0, n;
+    UCHAR_T k, num;
+    BOOL_T restart = TRUE;
+    SHORT_T error;
+    UCHAR_T *p_buf;
+
+    /* the driver replays on its own manager, the rotations only reach the counting callback */
+    sg_bench_counted = 0;
+    period = 60000000 / HALL_SW_TRACE_UNIT_US / scene->rpm;
+    jitter = period * scene->jitter / 100;
+    /* the next rotation starts at least this far away, so the edges of one rotation never pass it */
+    span = period - jitter;
+    base = period;
+    last = 0;
+    n = 0;
+    for (r = 0; r < scene->rotations; r++) {
+        num = __bench_gen_rotation(scene, span, edge);
+        for (k = 0; k < num; k++) {
+            t = base + edge[k];
+            if ((edges > 0) && ((INT_T)(t - last) < 0)) {
+                /* edges out of order would be replayed as a long pause, the result is meaningless */
+                TUYA_APP_LOG_ERROR("Bench %d: edge %d is out of order, scene aborted.", idx, edges);
+                return;
+            }
+            intv = t - last;
+            /* a saturated first interval starts the rotation from a known state */
+            if ((edges == 0) || (intv > 0xFFFF)) {
+                intv = 0xFFFF;
+            }
+            last = t;
+            buf[2 * n] = (UCHAR_T)(intv >> 8);
+            buf[2 * n + 1] = (UCHAR_T)(intv);
+            n++;
+            edges++;
+            if (n == BENCH_REPLAY_CHUNK) {
+                ticks += __bench_replay(buf, n, restart);
+                restart = FALSE;
+                n = 0;
+            }
+        }
+        base += period - jitter + (__bench_rand() % (2 * jitter + 1));
+    }
+    if (n > 0) {
+        ticks += __bench_replay(buf, n, restart);
+    }
+    counted = sg_bench_counted;
+
+    /* result: scene(1), rpm(2), rotations(2), edges(2), counted(2), error(2), ticks per edge(2) */
+    error = (SHORT_T)counted - (SHORT_T)scene->rotations;
+    p_buf = buf;
+    *p_buf++ = idx;
+    *p_buf++ = (UCHAR_T)(scene->rpm >> 8);
+    *p_buf++ = (UCHAR_T)(scene->rpm);
+    *p_buf++ = (UCHAR_T)(scene->rotations >> 8);
+    *p_buf++ = (UCHAR_T)(scene->rotations);
+    *p_buf++ = (UCHAR_T)(edges >> 8);
+    *p_buf++ = (UCHAR_T)(edges);
+    *p_buf++ = (UCHAR_T)(counted >> 8);
+    *p_buf++ = (UCHAR_T)(counted);
+    *p_buf++ = (UCHAR_T)((USHORT_T)error >> 8);
+    *p_buf++ = (UCHAR_T)(error);
+    t = (edges > 0) ? (ticks / edges) : 0;
+    *p_buf++ = (UCHAR_T)(t >> 8);
+    *p_buf++ = (UCHAR_T)(t);
+    ty_uart_debug_send(DEBUG_CMD_HALL_BENCH, buf, (p_buf - buf));
+    TUYA_APP_LOG_INFO("Bench %d: %drpm, %d rotations, %d edges, counted %d, %d ticks/edge.",
+                      idx, scene->rpm, scene->rotations, edges, counted, t);
+}
+
+/**
+ * @brief replay steady rotations that stop, check the stop rotating confirm time of the learned period
+ * @param[in] idx: scene index
+ * @return none
+ */
+STATIC VOID_T __stop_check_run_scene(IN CONST UCHAR_T idx)
+{
+    CONST STOP_CHECK_SCENE_T *scene = &sg_stop_check_scene[idx];
+    UCHAR_T buf[STOP_CHECK_EDGES_MAX * 2];
+    UINT_T period, confirm_ms;
+    USHORT_T intv;
+    UCHAR_T i;
+    BOOL_T pass;
+
+    /* the first interval is saturated so the replay starts from a pause, the others are one rotation */
+    intv = (USHORT_T)(60000000 / HALL_SW_TRACE_UNIT_US / scene->rpm);
+    for (i = 0; i < scene->edges; i++) {
+        buf[2 * i] = (i == 0) ? 0xFF : (UCHAR_T)(intv >> 8);
+        buf[2 * i + 1] = (i == 0) ? 0xFF : (UCHAR_T)(intv);
+    }
+    tuya_hall_sw_trace_replay(hall_sw_def_s.port, buf, scene->edges, TRUE, __debug_replay_cb);
+    period = tuya_hall_sw_get_replay_period();
+    confirm_ms = hula_hoop_get_stop_rotating_confirm_time(period);
+    pass = (confirm_ms == scene->confirm_ms);
+
+    /* result: scene(1), rpm(2), edges(1), period(4), confirm time(2), expected(2), pass(1) */
+    i = 0;
+    buf[i++] = idx;
+    buf[i++] = (UCHAR_T)(scene->rpm >> 8);
+    buf[i++] = (UCHAR_T)(scene->rpm);
+    buf[i++] = scene->edges;
+    __debug_put_u32(&buf[i], period);
+    i += 4;
+    buf[i++] = (UCHAR_T)(confirm_ms >> 8);
+    buf[i++] = (UCHAR_T)(confirm_ms);
+    buf[i++] = (UCHAR_T)(scene->confirm_ms >> 8);
+    buf[i++] = (UCHAR_T)(scene->confirm_ms);
+    buf[i++] = pass;
+    ty_uart_debug_send(DEBUG_CMD_STOP_CONFIRM, buf, i);
+    TUYA_APP_LOG_INFO("Stop check %d: %drpm, period %dus, confirm %dms, expected %dms, %s.",
+                      idx, scene->rpm, period, confirm_ms, scene->confirm_ms, (pass) ? "pass" : "FAIL");
+}
+
+/**
+ * @brief UART debug command handler, called by "tuya_uart_debug_handler()"
+ * @param[in] frame: debug frame
+ * @param[in] len: frame length
+ * @return none
+ */
+VOID_T hula_hoop_uart_debug_handler(IN UCHAR_T *frame, IN CONST USHORT_T len)
+{
+    USHORT_T data_len;
+
+    if (len < DEBUG_FRAME_LEN_MIN) {
+        return;
+    }
+    data_len = len - DEBUG_FRAME_LEN_MIN;
+    switch (frame[DEBUG_FRAME_OFFSET_TYPE]) {
+    case DEBUG_CMD_HALL_TRACE_DUMP:
+        __debug_dump_hall_trace();
+        break;
+    case DEBUG_CMD_HALL_TRACE_REPLAY:
+        /* data: restart(1), intervals in the trace format */
+        if (data_len >= 1) {
+            tuya_hall_sw_trace_replay(hall_sw_def_s.port, &frame[DEBUG_FRAME_OFFSET_DATA + 1],
+                                      (data_len - 1) / 2, (BOOL_T)frame[DEBUG_FRAME_OFFSET_DATA], __debug_replay_cb);
+        }
+        /* accepted edges of the replay are the rotations it would have counted */
+        __debug_send_hall_stat(DEBUG_CMD_HALL_TRACE_REPLAY);
+        break;
+    case DEBUG_CMD_HALL_STAT:
+        __debug_send_hall_stat(DEBUG_CMD_HALL_STAT);
+        break;
+    case DEBUG_CMD_KEY_LATENCY:
+        /* data: clear(1), optional, statistics are cleared after sent */
+        __debug_send_key_latency();
+        if ((data_len >= 1) && (frame[DEBUG_FRAME_OFFSET_DATA] != 0)) {
+            tuya_key_clear_latency();
+        }
+        break;
+    case DEBUG_CMD_HALL_QUEUE_TEST:
+        __debug_start_queue_test(&frame[DEBUG_FRAME_OFFSET_DATA], data_len);
+        break;
+    case DEBUG_CMD_STOP_CONFIRM:
+        {
+            UCHAR_T i;
+            for (i = 0; i < (SIZEOF(sg_stop_check_scene) / SIZEOF(sg_stop_check_scene[0])); i++) {
+                __stop_check_run_scene(i);
+            }
+        }
+        break;
+    case DEBUG_CMD_HALL_BENCH:
+        {
+            /* data: seed(1), optional */
+            UCHAR_T i;
+            sg_bench_seed = ((data_len >= 1) && (frame[DEBUG_FRAME_OFFSET_DATA] != 0)) ? frame[DEBUG_FRAME_OFFSET_DATA] : 1;
+            for (i = 0; i < (SIZEOF(sg_bench_scene) / SIZEOF(sg_bench_scene[0])); i++) {
+                __bench_run_scene(i);
+            }
+        }
+        break;
+    default:
+        break;
+    }
 }
@@ -12,6 +12,8 @@
 #include "tuya_hula_hoop_svc_basic.h"
 #include "tuya_hula_hoop_svc_disp.h"
 #include "tuya_hula_hoop_svc_data.h"
+#include "tuya_hula_hoop_svc_session.h"
+#include "tuya_hula_hoop_evt_user.h"
 #include "tuya_local_time.h"
 #include "tuya_ble_log.h"
 #include "timer.h"
@@ -135,6 +137,7 @@ VOID_T hula_hoop_set_device_sleep(VOID_T)
     /* set wakeup pin then sleep */
     GPIO_WAKEUP_MODULE_HIGH;
     cpu_set_gpio_wakeup(GPIO_WAKEUP_MODULE, Level_Low, 1);
+    hula_hoop_hall_set_wakeup();
     cpu_sleep_wakeup(DEEPSLEEP_MODE_RET_SRAM_LOW32K, PM_WAKEUP_PAD|PM_WAKEUP_TIMER, clock_time()+SLEEP_TIME_SEC*CLOCK_16M_SYS_TIMER_CLK_1S);
 }
 
@@ -149,6 +152,7 @@ STATIC VOID_T __set_device_status(IN CONST STAT_E stat)
     switch (stat) {
     case STAT_USING:
         TUYA_APP_LOG_INFO("Device status is 'using'.\n");
+        hula_hoop_session_on_stop();
         hula_hoop_disp_wakeup();
         break;
     case STAT_ROTATING:
@@ -157,6 +161,7 @@ STATIC VOID_T __set_device_status(IN CONST STAT_E stat)
         break;
     case STAT_UNUSED:
         TUYA_APP_LOG_INFO("Device status is 'unused'.\n");
+        hula_hoop_session_on_end();
         hula_hoop_clear_realtime_data();
         hula_hoop_disp_sleep();
         break;
@@ -272,7 +277,9 @@ VOID_T __set_device_work(VOID_T)
 VOID_T hula_hoop_device_wakeup_handler(VOID_T)
 {
     if (pm_get_wakeup_src() == (WAKEUP_STATUS_PAD | WAKEUP_STATUS_CORE)) {
-        /* wakeup from gpio */
+        /* wakeup from gpio, re-arm hall sensor first so that no rotation is lost */
+        hula_hoop_hall_wakeup_handler();
+        hula_hoop_key_wakeup_handler();
         __set_device_work();
     } else {
         /* wakeup from timer */
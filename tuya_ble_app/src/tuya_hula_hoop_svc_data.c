@@ -18,16 +18,41 @@
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
+#define CADENCE_MAX             999
+#define REALTIME_DATA_MAX       999
+
+/* calorie engine: energy of one rotation in ukcal, indexed by cadence */
+#define CALORIES_UNIT               1000000     /* ukcal per kcal */
+#define CALORIES_TABLE_SIZE         32
+#define CALORIES_CADENCE_SHIFT      4           /* 16rpm per table entry */
+#define CALORIES_CADENCE_MIN        30          /* rpm */
+#define CALORIES_CADENCE_DEFAULT    120         /* rpm, used before the cadence is known */
 
 /***********************************************************
 ***********************typedef define***********************
 ***********************************************************/
+typedef struct {
+    USHORT_T cadence;       /* lower bound of the band (rpm) */
+    UCHAR_T met;            /* MET x 10 */
+} CALORIES_MET_T;
 
 /***********************************************************
 ***********************variable define**********************
 ***********************************************************/
 HULA_HOOP_SPORT_DATA_T g_sport_data;
 
+/* approximate MET of hula hooping by cadence band, ascending */
+STATIC CONST CALORIES_MET_T sg_met_list[] = {
+    {0,   35},
+    {80,  40},
+    {120, 50},
+    {160, 60},
+    {200, 70}
+};
+STATIC UINT_T sg_calories_tbl[CALORIES_TABLE_SIZE];
+STATIC UINT_T sg_calories_frac = 0;    /* energy carried to the next rotation (ukcal) */
+STATIC UCHAR_T sg_user_weight = USER_WEIGHT_DEFAULT;
+
 /***********************************************************
 ***********************function define**********************
 ***********************************************************/
@@ -39,6 +64,60 @@ HULA_HOOP_SPORT_DATA_T g_sport_data;
 VOID_T hula_hoop_data_proc_init(VOID_T)
 {
     memset(&g_sport_data, 0, SIZEOF(HULA_HOOP_SPORT_DATA_T));
+    hula_hoop_set_user_weight(USER_WEIGHT_DEFAULT);
+}
+
+/**
+ * @brief build the calorie table for the user weight
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __build_calories_table(VOID_T)
+{
+    UCHAR_T i, j = 0;
+    UINT_T cadence;
+
+    for (i = 0; i < CALORIES_TABLE_SIZE; i++) {
+        /* middle of the cadence band of this entry */
+        cadence = (i << CALORIES_CADENCE_SHIFT) + (1 << (CALORIES_CADENCE_SHIFT - 1));
+        if (cadence < CALORIES_CADENCE_MIN) {
+            cadence = CALORIES_CADENCE_MIN;
+        }
+        while (((j + 1) < (SIZEOF(sg_met_list) / SIZEOF(sg_met_list[0]))) &&
+               (cadence >= sg_met_list[j + 1].cadence)) {
+            j++;
+        }
+        /* kcal = MET * kg * hours, one rotation lasts 60/cadence seconds:
+           ukcal = (MET*10) * kg * 1000000 / (10 * 60 * cadence) = (MET*10) * kg * 5000 / (3 * cadence) */
+        sg_calories_tbl[i] = ((UINT_T)sg_met_list[j].met * sg_user_weight * 5000 + (3 * cadence / 2)) / (3 * cadence);
+    }
+}
+
+/**
+ * @brief set user weight, rebuilds the calorie table
+ * @param[in] weight: user weight (kg)
+ * @return none
+ */
+VOID_T hula_hoop_set_user_weight(IN CONST UINT_T weight)
+{
+    if (weight < USER_WEIGHT_MIN) {
+        sg_user_weight = USER_WEIGHT_MIN;
+    } else if (weight > USER_WEIGHT_MAX) {
+        sg_user_weight = USER_WEIGHT_MAX;
+    } else {
+        sg_user_weight = weight;
+    }
+    __build_calories_table();
+}
+
+/**
+ * @brief get user weight
+ * @param[in] none
+ * @return user weight (kg)
+ */
+UCHAR_T hula_hoop_get_user_weight(VOID_T)
+{
+    return sg_user_weight;
 }
 
 /**
@@ -89,6 +168,23 @@ VOID_T hula_hoop_update_sport_data_count(VOID_T)
     g_sport_data.count_total_30days++;
 }
 
+/**
+ * @brief update sport data --cadence
+ * @param[in] period: average rotation period (us), 0 means not rotating
+ * @return none
+ */
+VOID_T hula_hoop_update_sport_data_cadence(IN CONST UINT_T period)
+{
+    UINT_T cadence;
+
+    if (period == 0) {
+        g_sport_data.cadence_realtime = 0;
+        return;
+    }
+    cadence = (60*1000*1000 + period/2) / period;
+    g_sport_data.cadence_realtime = (cadence > CADENCE_MAX) ? CADENCE_MAX : cadence;
+}
+
 /**
  * @brief update sport data --calories
  * @param[in] none
@@ -96,11 +192,29 @@ VOID_T hula_hoop_update_sport_data_count(VOID_T)
  */
 VOID_T hula_hoop_update_sport_data_calories(VOID_T)
 {
-    /* realtime */
-    g_sport_data.calories_realtime = g_sport_data.count_realtime / 10;
-    /* total */
-    g_sport_data.calories_total_today = g_sport_data.count_total_today / 10;
-    g_sport_data.calories_total_30days = g_sport_data.count_total_30days / 10;
+    UINT_T idx = g_sport_data.cadence_realtime;
+
+    /* energy of this rotation from the table, the remainder is carried */
+    if (idx == 0) {
+        idx = CALORIES_CADENCE_DEFAULT;
+    }
+    idx >>= CALORIES_CADENCE_SHIFT;
+    if (idx >= CALORIES_TABLE_SIZE) {
+        idx = CALORIES_TABLE_SIZE - 1;
+    }
+    sg_calories_frac += sg_calories_tbl[idx];
+    while (sg_calories_frac >= CALORIES_UNIT) {
+        sg_calories_frac -= CALORIES_UNIT;
+        /* realtime */
+        if (g_sport_data.calories_realtime < REALTIME_DATA_MAX) {
+            g_sport_data.calories_realtime++;
+        } else {
+            g_sport_data.calories_realtime = 0;
+        }
+        /* total */
+        g_sport_data.calories_total_today++;
+        g_sport_data.calories_total_30days++;
+    }
 }
 
 /**
@@ -148,6 +262,10 @@ VOID_T hula_hoop_update_total_data_day(VOID_T)
 {
     UCHAR_T i;
 
+    /* the last slot holds today, it leaves the window after 29 more days */
+    g_sport_data.time_total_days[SPORT_DATA_HISTORY_SIZE-1] = g_sport_data.time_total_today;
+    g_sport_data.count_total_days[SPORT_DATA_HISTORY_SIZE-1] = g_sport_data.count_total_today;
+    g_sport_data.calories_total_days[SPORT_DATA_HISTORY_SIZE-1] = g_sport_data.calories_total_today;
     g_sport_data.time_total_30days -= g_sport_data.time_total_days[0];
     g_sport_data.count_total_30days -= g_sport_data.count_total_days[0];
     g_sport_data.calories_total_30days -= g_sport_data.calories_total_days[0];
@@ -183,6 +301,7 @@ VOID_T hula_hoop_clear_realtime_data(VOID_T)
 {
     g_sport_data.time_realtime = 0;
     g_sport_data.count_realtime = 0;
+    g_sport_data.cadence_realtime = 0;
     g_sport_data.calories_realtime = 0;
 }
 
@@ -194,4 +313,5 @@ VOID_T hula_hoop_clear_realtime_data(VOID_T)
 VOID_T hula_hoop_clear_sport_data(VOID_T)
 {
     memset(&g_sport_data, 0, SIZEOF(g_sport_data));
+    sg_calories_frac = 0;
 }
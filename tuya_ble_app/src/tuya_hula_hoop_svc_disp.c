@@ -12,6 +12,7 @@
 #include "tuya_hula_hoop_svc_disp.h"
 #include "tuya_hula_hoop_svc_basic.h"
 #include "tuya_hula_hoop_svc_data.h"
+#include "tuya_hula_hoop_evt_user.h"
 #include "tuya_led.h"
 #include "tuya_seg_lcd.h"
 #include "tuya_ble_log.h"
@@ -19,7 +20,12 @@
 /***********************************************************
 ************************micro define************************
 ***********************************************************/
-#define LED_FLASH_INTV_MS       300
+#define LED_BREATH_STEP_MS      200
+#define LED_BREATH_OFF_MS       600
+#define LED_CHASE_STEP_MS       100
+#define LED_CHASE_ROUNDS        5
+#define LED_MASK(data)          (1 << (data))
+#define DISP_RENDER_KEY(mode, item, value)  (((UINT_T)(mode) << 24) | ((UINT_T)(item) << 16) | (USHORT_T)(value))
 #define SEG_LCD_FLASH_INTV_MS   500
 #define SEG_LCD_FLASH_COUNT     3
 
@@ -31,6 +37,8 @@ typedef struct {
     DISP_DATA_E data;
     LED_FUNC_E led_func;
     SEG_LCD_STAT_E seg_lcd_stat;
+    BOOL_T render_valid;            /* render_key matches the segment lcd content */
+    UINT_T render_key;              /* interface, item and value last rendered */
 } HULA_HOOP_DISP_T;
 
 /***********************************************************
@@ -43,6 +51,28 @@ STATIC TY_GPIO_PORT_E sg_user_led_pin[] = {
     TY_GPIOD_7    /* calories */
 };
 LED_HANDLE g_user_led_handle[(SIZEOF(sg_user_led_pin) / SIZEOF(sg_user_led_pin[0]))];
+/* all indicators in one group, bit n of a group mask is g_user_led_handle[n] */
+STATIC LED_GROUP_HANDLE sg_user_led_group;
+
+/* LED patterns */
+/* network pairing: breathing on the time/net led, it is the pwm pin */
+STATIC CONST LED_PAT_STEP_T sg_net_led_pat[] = {
+    LED_PAT_LEVEL(16, LED_BREATH_STEP_MS),
+    LED_PAT_LEVEL(64, LED_BREATH_STEP_MS),
+    LED_PAT_LEVEL(LED_LEVEL_MAX, LED_BREATH_STEP_MS),
+    LED_PAT_LEVEL(64, LED_BREATH_STEP_MS),
+    LED_PAT_LEVEL(16, LED_BREATH_STEP_MS),
+    LED_PAT_OFF(LED_BREATH_OFF_MS),
+    LED_PAT_REPEAT(0, 0)
+};
+/* goal reached: light chases over time, count and calories led */
+STATIC CONST LED_PAT_STEP_T sg_goal_led_pat[] = {
+    LED_PAT_MASK(LED_MASK(DISP_DATA_TIME), LED_CHASE_STEP_MS),
+    LED_PAT_MASK(LED_MASK(DISP_DATA_COUNT), LED_CHASE_STEP_MS),
+    LED_PAT_MASK(LED_MASK(DISP_DATA_CALORIES), LED_CHASE_STEP_MS),
+    LED_PAT_REPEAT(0, LED_CHASE_ROUNDS),
+    LED_PAT_END(0)
+};
 
 /* Segment LCD user define */
 SEG_LCD_PIN_T seg_lcd_pin_s = {
@@ -58,6 +88,7 @@ STATIC HULA_HOOP_DISP_T sg_disp;
 ***********************************************************/
 STATIC VOID_T __disp_target_remind_end_cb();
 STATIC VOID_T __disp_reset_remind_end_cb();
+STATIC VOID_T __disp_goal_led_end_cb();
 
 /**
  * @brief dispaly process module init
@@ -75,8 +106,13 @@ VOID_T hula_hoop_disp_proc_init(VOID_T)
             TUYA_APP_LOG_ERROR("led init err:%d", ret);
         }
     }
-    /* segment lcd init */
+    ret = tuya_create_led_group(g_user_led_handle, (SIZEOF(sg_user_led_pin) / SIZEOF(sg_user_led_pin[0])), &sg_user_led_group);
+    if (ret != LED_OK) {
+        TUYA_APP_LOG_ERROR("led group init err:%d", ret);
+    }
+    /* segment lcd init, off until the display wakes up */
     tuya_seg_lcd_init(seg_lcd_pin_s);
+    tuya_seg_lcd_sleep();
     /* variable init */
     memset(&sg_disp, 0, SIZEOF(HULA_HOOP_DISP_T));
 }
@@ -100,9 +136,8 @@ VOID_T hula_hoop_disp_proc_init_deepRetn(VOID_T)
  */
 STATIC VOID_T __set_net_led_status(VOID_T)
 {
-    tuya_set_led_flash(g_user_led_handle[DISP_DATA_TIME], LFM_FOREVER, LFT_STA_ON_END_ON, LED_FLASH_INTV_MS, LED_FLASH_INTV_MS, 0, NULL);
-    tuya_set_led_light(g_user_led_handle[DISP_DATA_COUNT], FALSE);
-    tuya_set_led_light(g_user_led_handle[DISP_DATA_CALORIES], FALSE);
+    tuya_set_led_group_light(sg_user_led_group, 0);
+    tuya_set_led_pattern(g_user_led_handle[DISP_DATA_TIME], sg_net_led_pat, NULL);
 }
 
 /**
@@ -112,18 +147,20 @@ STATIC VOID_T __set_net_led_status(VOID_T)
  */
 STATIC VOID_T __set_data_led_status(IN CONST DISP_DATA_E data)
 {
-    UCHAR_T i;
+    UCHAR_T mask;
 
     if (sg_disp.led_func == LED_FUNC_BIND) {
         return;
     }
-    for (i = 0; i < (SIZEOF(sg_user_led_pin) / SIZEOF(sg_user_led_pin[0])); i++) {
-        if (i == data) {
-            tuya_set_led_light(g_user_led_handle[i], TRUE);
-        } else {
-            tuya_set_led_light(g_user_led_handle[i], FALSE);
-        }
+    /* cadence is indicated by time and count led together */
+    if (data == DISP_DATA_CADENCE) {
+        mask = LED_MASK(DISP_DATA_TIME) | LED_MASK(DISP_DATA_COUNT);
+    } else if (data < (SIZEOF(sg_user_led_pin) / SIZEOF(sg_user_led_pin[0]))) {
+        mask = LED_MASK(data);
+    } else {
+        mask = 0;
     }
+    tuya_set_led_group_light(sg_user_led_group, mask);
 }
 
 /**
@@ -136,10 +173,11 @@ STATIC VOID_T __set_seg_lcd_status(IN CONST SEG_LCD_STAT_E stat)
     sg_disp.seg_lcd_stat = stat;
     switch (stat) {
     case SEG_LCD_STAT_OFF:
-        tuya_seg_lcd_set_light(FALSE);
+        tuya_seg_lcd_sleep();
         break;
     case SEG_LCD_STAT_ON:
         tuya_seg_lcd_set_light(TRUE);
+        tuya_seg_lcd_wakeup();
         break;
     case SEG_LCD_STAT_FLASH:
         if (sg_disp.mode == DISP_TARGET_MODE) {
@@ -148,6 +186,7 @@ STATIC VOID_T __set_seg_lcd_status(IN CONST SEG_LCD_STAT_E stat)
         if (sg_disp.mode == DISP_RESET_REMIND) {
             tuya_seg_lcd_set_flash(SEG_LCD_FLASH_DIGIT_ALL, SLFT_STA_ON_END_OFF, SEG_LCD_FLASH_INTV_MS, SEG_LCD_FLASH_COUNT, __disp_reset_remind_end_cb);
         }
+        tuya_seg_lcd_wakeup();
         break;
     default:
         break;
@@ -155,25 +194,43 @@ STATIC VOID_T __set_seg_lcd_status(IN CONST SEG_LCD_STAT_E stat)
 }
 
 /**
- * @brief set lcd display content of normal mode interface
+ * @brief get the value shown by normal mode interface
  * @param[in] data: display data
- * @return none
+ * @return value, 0 if no data is shown
  */
-STATIC VOID_T __set_seg_lcd_disp_normal_mode(IN CONST DISP_DATA_E data)
+STATIC USHORT_T __get_disp_normal_value(IN CONST DISP_DATA_E data)
 {
+    USHORT_T value = 0;
+
     switch (data) {
     case DISP_DATA_TIME:
-        tuya_seg_lcd_disp_num(g_sport_data.time_realtime, 0);
+        value = g_sport_data.time_realtime;
         break;
     case DISP_DATA_COUNT:
-        tuya_seg_lcd_disp_num(g_sport_data.count_realtime, 0);
+        value = g_sport_data.count_realtime;
         break;
     case DISP_DATA_CALORIES:
-        tuya_seg_lcd_disp_num(g_sport_data.calories_realtime, 0);
+        value = g_sport_data.calories_realtime;
+        break;
+    case DISP_DATA_CADENCE:
+        value = g_sport_data.cadence_realtime;
         break;
     default:
         break;
     }
+    return value;
+}
+
+/**
+ * @brief set lcd display content of normal mode interface
+ * @param[in] data: display data
+ * @return none
+ */
+STATIC VOID_T __set_seg_lcd_disp_normal_mode(IN CONST DISP_DATA_E data)
+{
+    if (data < DISP_DATA_NONE) {
+        tuya_seg_lcd_disp_num(__get_disp_normal_value(data), 0);
+    }
 }
 
 /**
@@ -220,12 +277,46 @@ STATIC VOID_T __set_seg_lcd_disp_reset_remind(VOID_T)
 }
 
 /**
- * @brief display process module loop
+ * @brief get the render key of the current interface, it changes whenever the lcd content would change
+ * @param[in] none
+ * @return render key
+ */
+STATIC UINT_T __get_disp_render_key(VOID_T)
+{
+    UINT_T key;
+
+    switch (sg_disp.mode) {
+    case DISP_NORMAL_MODE:
+        key = DISP_RENDER_KEY(sg_disp.mode, sg_disp.data, __get_disp_normal_value(sg_disp.data));
+        break;
+    case DISP_TARGET_MODE:
+        key = DISP_RENDER_KEY(sg_disp.mode, 0, g_sport_data.time_remain_today);
+        break;
+    case DISP_MODE_SELECT:
+        key = DISP_RENDER_KEY(sg_disp.mode, g_hula_hoop.mode_temp, 0);
+        break;
+    default:
+        key = DISP_RENDER_KEY(sg_disp.mode, 0, 0);
+        break;
+    }
+    return key;
+}
+
+/**
+ * @brief render the lcd content of the current interface, only if it changed since the last render
  * @param[in] none
  * @return none
  */
-VOID_T hula_hoop_disp_proc_loop(VOID_T)
+STATIC VOID_T __set_seg_lcd_disp_render(VOID_T)
 {
+    UINT_T key = __get_disp_render_key();
+
+    if ((sg_disp.render_valid) && (key == sg_disp.render_key)) {
+        return;
+    }
+    sg_disp.render_key = key;
+    sg_disp.render_valid = TRUE;
+
     switch (sg_disp.mode) {
     case DISP_NORMAL_MODE:
         __set_seg_lcd_disp_normal_mode(sg_disp.data);
@@ -242,6 +333,18 @@ VOID_T hula_hoop_disp_proc_loop(VOID_T)
     default:
         break;
     }
+    /* the key that asked for this content is seen by the user now */
+    hula_hoop_key_disp_refreshed();
+}
+
+/**
+ * @brief display process module loop
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_disp_proc_loop(VOID_T)
+{
+    __set_seg_lcd_disp_render();
 }
 
 /**
@@ -255,7 +358,7 @@ VOID_T hula_hoop_disp_switch_to_normal_mode(VOID_T)
     sg_disp.data = DISP_DATA_TIME;
     __set_data_led_status(sg_disp.data);
     __set_seg_lcd_status(SEG_LCD_STAT_ON);
-    __set_seg_lcd_disp_normal_mode(DISP_DATA_TIME);
+    __set_seg_lcd_disp_render();
 }
 
 /**
@@ -269,7 +372,7 @@ VOID_T hula_hoop_disp_switch_to_target_mode(VOID_T)
     sg_disp.data = DISP_DATA_TIME;
     __set_data_led_status(sg_disp.data);
     __set_seg_lcd_status(SEG_LCD_STAT_ON);
-    __set_seg_lcd_disp_target_mode();
+    __set_seg_lcd_disp_render();
 }
 
 /**
@@ -283,7 +386,7 @@ VOID_T hula_hoop_disp_switch_to_mode_select(VOID_T)
     sg_disp.data = DISP_DATA_NONE;
     __set_data_led_status(sg_disp.data);
     __set_seg_lcd_status(SEG_LCD_STAT_ON);
-    __set_seg_lcd_disp_mode_select();
+    __set_seg_lcd_disp_render();
 }
 
 /**
@@ -297,7 +400,7 @@ VOID_T hula_hoop_disp_switch_to_reset_remind(VOID_T)
     sg_disp.data = DISP_DATA_NONE;
     __set_data_led_status(sg_disp.data);
     __set_seg_lcd_status(SEG_LCD_STAT_FLASH);
-    __set_seg_lcd_disp_reset_remind();
+    __set_seg_lcd_disp_render();
 }
 
 /**
@@ -381,6 +484,16 @@ DISP_MODE_E hula_hoop_get_disp_mode(VOID_T)
     return sg_disp.mode;
 }
 
+/**
+ * @brief get the render key of the current interface, it changes whenever the lcd content would change
+ * @param[in] none
+ * @return render key
+ */
+UINT_T hula_hoop_get_disp_render_key(VOID_T)
+{
+    return __get_disp_render_key();
+}
+
 /**
  * @brief switch displayed data
  * @param[in] none
@@ -389,6 +502,12 @@ DISP_MODE_E hula_hoop_get_disp_mode(VOID_T)
 VOID_T hula_hoop_switch_disp_data(VOID_T)
 {
     if (sg_disp.data == DISP_DATA_CALORIES) {
+        if (hula_hoop_get_device_status() != STAT_ROTATING) {
+            sg_disp.data = DISP_DATA_TIME;
+        } else {
+            sg_disp.data = DISP_DATA_CADENCE;
+        }
+    } else if (sg_disp.data == DISP_DATA_CADENCE) {
         if (hula_hoop_get_device_status() != STAT_ROTATING) {
             sg_disp.data = DISP_DATA_TIME;
         }
@@ -410,6 +529,9 @@ VOID_T hula_hoop_disp_target_finish(VOID_T)
     if (sg_disp.mode == DISP_TARGET_MODE) {
         __set_seg_lcd_status(SEG_LCD_STAT_FLASH);
     }
+    if (sg_disp.led_func == LED_FUNC_DATA) {
+        tuya_set_led_group_pattern(sg_user_led_group, sg_goal_led_pat, __disp_goal_led_end_cb);
+    }
 }
 
 /**
@@ -431,3 +553,13 @@ STATIC VOID_T __disp_reset_remind_end_cb()
 {
     hula_hoop_set_device_status(STAT_RESET);
 }
+
+/**
+ * @brief display goal reached led pattern end callback
+ * @param[in] none
+ * @return none
+ */
+STATIC VOID_T __disp_goal_led_end_cb()
+{
+    __set_data_led_status(sg_disp.data);
+}
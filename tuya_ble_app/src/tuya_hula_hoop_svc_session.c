@@ -0,0 +1,186 @@
+/**
+ * @file tuya_hula_hoop_svc_session.c
+ * @author lifan
+ * @brief hula hoop workout session service processing module source file
+ * @version 1.0
+ * @date 2021-09-23
+ *
+ * @copyright Copyright (c) tuya.inc 2021
+ *
+ */
+
+#include "tuya_hula_hoop_svc_session.h"
+#include "tuya_local_time.h"
+#include "tuya_ble_log.h"
+
+/***********************************************************
+************************micro define************************
+***********************************************************/
+#define SESSION_CADENCE_MAX     999
+#define SESSION_FIELD_MAX       0xFFFF
+
+/***********************************************************
+***********************typedef define***********************
+***********************************************************/
+typedef struct {
+    BOOL_T active;          /* a session is in progress */
+    BOOL_T set_open;        /* the current set is still rotating */
+    UINT_T clock_ms;        /* session clock */
+    UINT_T start_ms;        /* clock of the first rotation of the current set */
+    UINT_T last_ms;         /* clock of the last rotation of the current set */
+    UINT_T end_ms;          /* clock of the last rotation of the previous set */
+    UINT_T count;           /* rotations of the current set */
+    UINT_T start_time;      /* local time of the current set, seconds of the day */
+    UCHAR_T sets;           /* sets closed in this session */
+} SESSION_STATE_T;
+
+typedef struct {
+    SESSION_SET_T set[SESSION_SET_TABLE_SIZE];
+    UCHAR_T head;           /* next write position */
+    UCHAR_T num;            /* valid sets, oldest are overwritten when full */
+} SESSION_SET_TABLE_T;
+
+/***********************************************************
+***********************variable define**********************
+***********************************************************/
+STATIC SESSION_STATE_T sg_session;
+STATIC SESSION_SET_TABLE_T sg_set_table;
+
+/***********************************************************
+***********************function define**********************
+***********************************************************/
+/**
+ * @brief workout session process module init
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_session_init(VOID_T)
+{
+    memset(&sg_session, 0, SIZEOF(SESSION_STATE_T));
+    memset(&sg_set_table, 0, SIZEOF(SESSION_SET_TABLE_T));
+}
+
+/**
+ * @brief update the session clock, called by the 100ms timer
+ * @param[in] time_inc: time increment (ms)
+ * @return none
+ */
+VOID_T hula_hoop_session_update_time(IN CONST UINT_T time_inc)
+{
+    sg_session.clock_ms += time_inc;
+}
+
+/**
+ * @brief convert milliseconds to a 16-bit seconds field
+ * @param[in] ms: time (ms)
+ * @return time (s), saturated
+ */
+STATIC USHORT_T __ms_to_sec_field(IN CONST UINT_T ms)
+{
+    UINT_T sec = (ms + 500) / 1000;
+    return (sec > SESSION_FIELD_MAX) ? SESSION_FIELD_MAX : (USHORT_T)sec;
+}
+
+/**
+ * @brief session process on one valid rotation
+ * @param[in] age_ms: time from the rotation edge to now (ms)
+ * @return none
+ */
+VOID_T hula_hoop_session_on_rotation(IN CONST UINT_T age_ms)
+{
+    /* rotations held by the hall classifier arrive together, date each one back to its edge */
+    UINT_T edge_ms = sg_session.clock_ms - age_ms;
+
+    /* a new session clears the set table of the previous one */
+    if (!sg_session.active) {
+        sg_session.active = TRUE;
+        sg_session.sets = 0;
+        sg_set_table.head = 0;
+        sg_set_table.num = 0;
+    }
+    if (!sg_session.set_open) {
+        sg_session.set_open = TRUE;
+        sg_session.start_ms = edge_ms;
+        sg_session.count = 0;
+        sg_session.start_time = (UINT_T)g_local_time.hour * 3600 + (UINT_T)g_local_time.minute * 60 + g_local_time.second;
+    }
+    sg_session.last_ms = edge_ms;
+    sg_session.count++;
+}
+
+/**
+ * @brief session process when the rotation stops, closes the current set
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_session_on_stop(VOID_T)
+{
+    SESSION_SET_T *set;
+    UINT_T span, cadence;
+
+    if (!sg_session.set_open) {
+        return;
+    }
+    sg_session.set_open = FALSE;
+
+    set = &sg_set_table.set[sg_set_table.head];
+    span = sg_session.last_ms - sg_session.start_ms;
+    set->start_time = sg_session.start_time;
+    set->duration = __ms_to_sec_field(span);
+    set->count = (sg_session.count > SESSION_FIELD_MAX) ? SESSION_FIELD_MAX : (USHORT_T)sg_session.count;
+    /* mean cadence over the intervals between the first and the last rotation */
+    cadence = 0;
+    if ((sg_session.count > 1) && (span > 0)) {
+        cadence = ((sg_session.count - 1) * 60000 + span / 2) / span;
+        if (cadence > SESSION_CADENCE_MAX) {
+            cadence = SESSION_CADENCE_MAX;
+        }
+    }
+    set->cadence = (USHORT_T)cadence;
+    set->rest = (sg_session.sets > 0) ? __ms_to_sec_field(sg_session.start_ms - sg_session.end_ms) : 0;
+    sg_session.end_ms = sg_session.last_ms;
+    if (sg_session.sets < 0xFF) {
+        sg_session.sets++;
+    }
+
+    sg_set_table.head = (sg_set_table.head + 1) % SESSION_SET_TABLE_SIZE;
+    if (sg_set_table.num < SESSION_SET_TABLE_SIZE) {
+        sg_set_table.num++;
+    }
+    TUYA_APP_LOG_INFO("Set %d: %ds, %d rotations, %drpm, rest %ds.",
+                      sg_session.sets, set->duration, set->count, set->cadence, set->rest);
+}
+
+/**
+ * @brief session process when the device is no longer used, ends the session
+ * @param[in] none
+ * @return none
+ */
+VOID_T hula_hoop_session_on_end(VOID_T)
+{
+    hula_hoop_session_on_stop();
+    sg_session.active = FALSE;
+}
+
+/**
+ * @brief get the number of sets in the set table
+ * @param[in] none
+ * @return number of sets
+ */
+UCHAR_T hula_hoop_get_session_set_num(VOID_T)
+{
+    return sg_set_table.num;
+}
+
+/**
+ * @brief get one set from the set table
+ * @param[in] idx: set index, 0 is the oldest set
+ * @return set address, NULL if the index is out of range
+ */
+CONST SESSION_SET_T *hula_hoop_get_session_set(IN CONST UCHAR_T idx)
+{
+    if (idx >= sg_set_table.num) {
+        return NULL;
+    }
+    return &sg_set_table.set[(sg_set_table.head + SESSION_SET_TABLE_SIZE - sg_set_table.num + idx) % SESSION_SET_TABLE_SIZE];
+}